@@ -0,0 +1,138 @@
+#ifndef SANI_ANIMATIONHOST_HPP_
+#define SANI_ANIMATIONHOST_HPP_
+
+//@PURPOSE: Provide a single clock and animation shared by many views
+//
+//@CLASSES:
+//  sani::AnimationHost: pulls one 'InteractiveAnimation' for many views
+//
+//@SEE_ALSO: sani_interactiveanimationview, sani_framescheduler,
+//           sani_inputtriggers
+//
+//@DESCRIPTION: This component provides a class, 'AnimationHost', that runs
+// one 'InteractiveAnimation' on behalf of any number of
+// 'InteractiveAnimationView's, e.g. to mirror one scene on several monitors.
+// The host owns the clock of the animation, the 'FrameScheduler' that decides
+// when frames are pulled, and the 'Animation' created from the interactive
+// animation. On every tick it pulls one frame and emits it with
+// 'framePulled'; every view attached with
+// 'InteractiveAnimationView::setAnimationHost' presents that same frame, so
+// the cost of pulling is paid once, however many views there are, and all of
+// them show the same time.
+//
+// Attached views forward their user input to the host with 'postInput', but
+// only while they have the keyboard focus, so the animation receives the
+// input of one view at a time. Input is timestamped with the host's clock
+// and delivered in one batch before the next frame is pulled, just like with
+// a view that runs its own animation.
+//
+// Like a view, a host can be told that its animation only changes in
+// response to user input, in which case it stops ticking as soon as a frame
+// is unchanged and no input was posted since the previous frame, and resumes
+// with the next posted input. The attached views then present no frames in
+// between. 'InteractiveAnimationView::setTimeIndependent' has no effect on
+// hosted views.
+//
+// Likewise, frames are optimized with 'optimizeDrawing' (see
+// 'sani_optimizedrawing') once by the host, if enabled with
+// 'setFrameOptimization', rather than by each view.
+//
+// Frames are pulled on the thread of the host, which must be the thread of
+// the attached views.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Mirror a scene on every screen
+// - - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::AnimationHost host;
+// host.setInteractiveAnimation(interactiveAnimation);
+// std::vector<std::unique_ptr<sani::InteractiveAnimationView>> views;
+// for (QScreen* screen : QGuiApplication::screens()) {
+//   views.emplace_back(new sani::InteractiveAnimationView());
+//   views.back()->setAnimationHost(&host);
+//   views.back()->setGeometry(screen->geometry());
+//   views.back()->show();
+// }
+//..
+
+#include <sani/drawing.hpp>
+#include <sani/interactiveanimation.hpp>
+#include <sani/userinput.hpp>
+
+#include <boost/optional.hpp>
+#include <QObject>
+#include <QPointF>
+#include <memory>
+
+namespace sani {
+
+class FrameScheduler;
+
+// This class implements the shared clock and animation of a group of views.
+class AnimationHost : public QObject {
+  Q_OBJECT
+ public:
+  // Create an 'AnimationHost' object with no animation, whose scheduler is
+  // a 'TimerFrameScheduler' ticking at 60 Hz.
+  AnimationHost();
+
+  ~AnimationHost();
+
+  // Set the hosted animation to the specified 'interactiveAnimation', whose
+  // mouse position is initially the optionally specified 'mousePos', restart
+  // the clock, and start pulling frames.
+  void setInteractiveAnimation(const InteractiveAnimation& interactiveAnimation,
+                               const QPointF& mousePos = QPointF());
+
+  // Set the scheduler that decides when frames are pulled to the specified
+  // 'scheduler'.
+  void setFrameScheduler(std::unique_ptr<FrameScheduler> scheduler);
+
+  // Return the scheduler that decides when frames are pulled.
+  FrameScheduler& frameScheduler() const;
+
+  // Set whether the current and future hosted animations only change in
+  // response to user input to the specified 'timeIndependent'. When 'true',
+  // frames are not pulled while no input is posted and the last frame was
+  // unchanged. The default is 'false'.
+  void setTimeIndependent(bool timeIndependent);
+
+  // Set whether frames are optimized with 'optimizeDrawing' before they are
+  // emitted to the specified 'enabled'. The default is 'false'.
+  void setFrameOptimization(bool enabled);
+
+  // Return the time of the hosted animation in seconds.
+  double time() const;
+
+  // Queue the specified 'event' for delivery to the hosted animation before
+  // the next frame is pulled, and resume pulling frames if stopped. Do
+  // nothing if there is no hosted animation.
+  void postInput(const InputEvent& event);
+
+Q_SIGNALS:
+  // This signal is emitted for every pulled frame with the specified
+  // 'opDrawing', which is 'boost::none' if the animation ended, and the
+  // specified 'pullNsecs' that pulling and optimizing it took.
+  void framePulled(const boost::optional<sani::Drawing>& opDrawing,
+                   qint64 pullNsecs);
+
+ private
+Q_SLOTS:
+
+  // Deliver the queued input, pull a new frame from the hosted animation,
+  // and emit 'framePulled'.
+  void pullFrame();
+
+ private:
+  // Note that user input arrived and resume pulling frames if stopped.
+  void wake();
+
+  struct Impl;
+  const std::unique_ptr<Impl> m_impl;
+};
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef SANI_BOUNDINGRECT_HPP_
+#define SANI_BOUNDINGRECT_HPP_
+
+//@PURPOSE: Provide the extent of 'Drawing's for culling and invalidation
+//
+//@CLASSES:
+//  sani::DrawingBounds: the area covered by a drawing
+//
+//@SEE_ALSO: sani_drawing
+//
+//@DESCRIPTION: This component provides functions that compute the area that a
+// 'Drawing' paints. Strokes are accounted for using the width, cap style, and
+// join style of each primitive's pen, and the matrices of nested
+// 'DrawTransform' nodes are applied to the bounds of their children.
+//
+// Cosmetic pens (see 'QPen::isCosmetic') have a width in device pixels rather
+// than in drawing coordinates, so their extent cannot be expressed as part of
+// a rectangle in drawing coordinates. 'DrawingBounds' therefore carries a
+// separate 'cosmeticMargin', in device pixels, that covers cosmetic strokes as
+// well as antialiasing. Adding it on all sides of the device-space mapping of
+// 'rect' gives a conservative device-space extent of the drawing.
+//
+// The bounds of a 'DrawLOD' node cover all of its levels, whichever of them
+// is painted, so they do not depend on the scale of the painter.
+//
+// The bounds of 'DrawOver', 'DrawGroup', 'DrawTransform', 'DrawInstances',
+// and 'DrawLOD' nodes are computed once and cached in the node, so repeated
+// queries on a drawing that mostly consists of shared, unchanged subtrees
+// only visit the new nodes. The cache may be filled concurrently from several
+// threads.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Decide whether a drawing is visible
+// - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// const sani::DrawingBounds bounds = sani::drawingBounds(drawing);
+// const bool visible =
+//     !bounds.isEmpty &&
+//     sani::deviceRect(bounds, painter.combinedTransform())
+//         .intersects(QRectF(painter.viewport()));
+//..
+
+#include <sani/drawing.hpp>
+
+#include <QRectF>
+
+namespace sani {
+
+// This class implements a value-semantic description of the area covered by
+// a 'Drawing'.
+struct DrawingBounds {
+  // Create a 'DrawingBounds' object describing a drawing that paints nothing.
+  DrawingBounds() : isEmpty(true), cosmeticMargin(0.0) {}
+
+  // Create a 'DrawingBounds' object with the specified 'rect' and
+  // 'cosmeticMargin'.
+  DrawingBounds(const QRectF& rect_, qreal cosmeticMargin_)
+      : isEmpty(false), rect(rect_), cosmeticMargin(cosmeticMargin_) {}
+
+  bool isEmpty;  // 'true' if the drawing paints nothing, in which case the
+                 // other members are meaningless.
+
+  QRectF rect;  // Area, in drawing coordinates, covered by the geometry and
+                // the non-cosmetic strokes of the drawing
+
+  qreal cosmeticMargin;  // Margin, in device pixels, by which cosmetic
+                         // strokes and antialiasing may extend beyond 'rect'
+};
+
+// Return the bounds of the specified 'd'.
+DrawingBounds drawingBounds(const Drawing& d);
+
+// Return the smallest rectangle, in the coordinates of the specified 'd', that
+// contains 'rect' of 'drawingBounds(d)', or a null rectangle if 'd' paints
+// nothing.
+QRectF boundingRect(const Drawing& d);
+
+// Return the smallest rectangle, in the device coordinates of the specified
+// 'toDevice' transform, that contains everything the specified 'bounds' may
+// cover.
+QRectF deviceRect(const DrawingBounds& bounds, const QTransform& toDevice);
+}
+
+#endif
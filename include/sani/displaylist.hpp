@@ -0,0 +1,100 @@
+#ifndef SANI_DISPLAYLIST_HPP_
+#define SANI_DISPLAYLIST_HPP_
+
+//@PURPOSE: Provide a flat, pre-transformed form of a 'Drawing' for painting
+//
+//@CLASSES:
+//  sani::DisplayList: a contiguous buffer of transform-resolved primitives
+//
+//@SEE_ALSO: sani_drawing, sani_primitive
+//
+//@DESCRIPTION: This component provides a struct, 'DisplayList', and a function,
+// 'compile', that flattens a 'Drawing' tree into a single contiguous sequence
+// of primitives in painting order. Each command refers to an entry in a table
+// of transforms that have already been fully resolved, i.e. each entry is the
+// product of all the 'DrawTransform' nodes and 'DrawInstances' instances
+// enclosing the primitive. The template of a 'DrawInstances' node is expanded
+// once per instance, with the colours of the instance applied. Of each
+// 'DrawLOD' node only the level for the scale given by the transform to
+// device coordinates passed to 'compile' is kept, so a display list has to be
+// compiled again when that scale changes.
+//
+// Painting a 'DisplayList' with 'draw' is a linear loop over the commands that
+// only touches the painter's transform when it differs from that of the
+// previous command. Compiling a 'Drawing' once and painting the result is
+// worthwhile when the same frame is painted several times or when the
+// 'Drawing' is very deep.
+//
+// 'drawBatched' paints the same output as 'draw' but additionally skips pen,
+// brush, and font changes that would not alter the painter's state and merges
+// runs of consecutive 'DrawLine', 'DrawRect', and 'DrawPoint' commands that
+// share a transform and style into single 'drawLines', 'drawRects', and
+// 'drawPoints' calls. Lines and points are only merged when their pen is
+// opaque since the array overloads composite overlapping parts only once.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Paint a compiled drawing
+// - - - - - - - - - - - - - - - - - -
+//..
+// const sani::DisplayList displayList = sani::compile(drawing);
+// sani::draw(displayList, painter);
+//..
+
+#include <sani/drawing.hpp>
+#include <sani/primitive.hpp>
+
+#include <QTransform>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+class QPainter;
+
+namespace sani {
+
+// This class implements a value-semantic, flattened representation of a
+// 'Drawing'.
+struct DisplayList {
+  // A single primitive and the transform it is painted with.
+  struct Command {
+    Command() : transformIndex(0) {}
+    Command(std::size_t transformIndex_, Primitive primitive_)
+        : transformIndex(transformIndex_), primitive(std::move(primitive_)) {}
+
+    std::size_t transformIndex;  // Index into 'transforms' of the transform
+                                 // 'primitive' is painted with.
+
+    Primitive primitive;  // The primitive to paint
+  };
+
+  // Create an empty 'DisplayList' object. The transform table contains only
+  // the identity transform.
+  DisplayList();
+
+  std::vector<QTransform> transforms;  // Resolved transforms. The first entry
+                                       // is always the identity transform.
+
+  std::vector<Command> commands;  // Primitives in painting order
+};
+
+// Return the 'DisplayList' equivalent of the specified 'd' when painted with
+// the optionally specified 'toDevice' transform to device coordinates, which
+// selects the levels of 'DrawLOD' nodes.
+DisplayList compile(const Drawing& d,
+                    const QTransform& toDevice = QTransform());
+
+// Paint the specified 'displayList' using the specified 'painter'. The
+// transforms of 'displayList' are applied relative to the world transform
+// 'painter' has on entry, which is restored before returning.
+void draw(const DisplayList& displayList, QPainter& painter);
+
+// Paint the specified 'displayList' using the specified 'painter' like 'draw',
+// but merge runs of primitives that share a style into single calls and skip
+// redundant changes to the pen, brush, and font of 'painter'.
+void drawBatched(const DisplayList& displayList, QPainter& painter);
+}
+
+#endif
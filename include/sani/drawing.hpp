@@ -1,25 +1,76 @@
 #ifndef SANI_DRAWING_HPP_
 #define SANI_DRAWING_HPP_
 
+//@PURPOSE: Provide 'Drawing', an immutable tree of 2D drawing operations
+//
+//@CLASSES:
+//  sani::Drawing: a primitive or a composition of drawings
+//
+//@SEE_ALSO: sani_boundingrect, sani_displaylist, sani_drawinghash
+//
+//@DESCRIPTION: This component provides a variant type, 'Drawing', whose
+// alternatives are primitives, such as 'DrawRect' and 'DrawText', and
+// composite nodes, such as 'DrawOver' and 'DrawTransform', that refer to
+// their children through shared pointers to immutable drawings. Drawings are
+// cheap to copy, and unchanged parts of a scene are shared between frames.
+// Drawings are built with the 'draw...' functions and painted with 'draw'.
+//
+// Every function that walks a drawing, in this component and the ones built
+// on it, does so with explicit stacks rather than by recursion, and so does
+// the destructor of a drawing. The depth of a drawing is therefore limited by
+// the available memory rather than by the size of the call stack, and a
+// drawing composed of long chains of 'drawOver' calls can be painted,
+// measured, and destroyed safely.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Draw a framed label
+// - - - - - - - - - - - - - - -
+//..
+// const sani::Drawing label = sani::drawOver(
+//     sani::drawRect(QPen(Qt::black), QBrush(Qt::white), QRectF(0, 0, 4, 1)),
+//     sani::drawText(QPen(Qt::black), QBrush(), QFont(), QPointF(0.1, 0.8),
+//                    "Hello"));
+// sani::draw(label, painter);
+//..
+
 #include <QPen>
 #include <QBrush>
+#include <QColor>
 #include <QPointF>
 #include <QRectF>
 #include <QFont>
 #include <QTransform>
 
+#include <boost/mpl/begin.hpp>
+#include <boost/mpl/distance.hpp>
+#include <boost/mpl/find.hpp>
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
 #include <boost/variant.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace sani {
     struct DrawLine
     {
         DrawLine() {};
         DrawLine
-            ( const QPen & pen_
+            ( QPen pen_
             , const QPointF & p1_
             , const QPointF & p2_
             )
-            : pen( pen_ )
+            : pen( std::move( pen_ ) )
             , p1( p1_ )
             , p2( p2_ )
         {
@@ -32,12 +83,12 @@ namespace sani {
     {
         DrawRect() {};
         DrawRect
-            ( const QPen & pen_
-            , const QBrush & brush_
+            ( QPen pen_
+            , QBrush brush_
             , const QRectF & rect_
             )
-            : pen( pen_ )
-            , brush( brush_ )
+            : pen( std::move( pen_ ) )
+            , brush( std::move( brush_ ) )
             , rect( rect_ )
         {
         }
@@ -49,17 +100,17 @@ namespace sani {
     {
         DrawText() {};
         DrawText
-            ( const QPen & pen_
-            , const QBrush & brush_
-            , const QFont & font_
+            ( QPen pen_
+            , QBrush brush_
+            , QFont font_
             , const QPointF & position_
-            , const std::string & text_
+            , std::string text_
             )
-            : pen( pen_ )
-            , brush( brush_ )
-            , font( font_ )
+            : pen( std::move( pen_ ) )
+            , brush( std::move( brush_ ) )
+            , font( std::move( font_ ) )
             , position( position_ )
-            , text( text_ )
+            , text( std::move( text_ ) )
         {
         }
         QPen pen;
@@ -72,12 +123,12 @@ namespace sani {
     {
         DrawEllipse() {};
         DrawEllipse
-            ( const QPen & pen_
-            , const QBrush & brush_
+            ( QPen pen_
+            , QBrush brush_
             , const QRectF & rect_
             )
-            : pen( pen_ )
-            , brush( brush_ )
+            : pen( std::move( pen_ ) )
+            , brush( std::move( brush_ ) )
             , rect( rect_ )
         {
         }
@@ -89,14 +140,14 @@ namespace sani {
     {
         DrawArc() {};
         DrawArc
-            ( const QPen & pen_
-            , const QBrush & brush_
+            ( QPen pen_
+            , QBrush brush_
             , const QRectF & rect_
             , const double & startAngle_
             , const double & spanAngle_
             )
-            : pen( pen_ )
-            , brush( brush_ )
+            : pen( std::move( pen_ ) )
+            , brush( std::move( brush_ ) )
             , rect( rect_ )
             , startAngle( startAngle_ )
             , spanAngle( spanAngle_ )
@@ -112,14 +163,14 @@ namespace sani {
     {
         DrawPie() {};
         DrawPie
-            ( const QPen & pen_
-            , const QBrush & brush_
+            ( QPen pen_
+            , QBrush brush_
             , const QRectF & rect_
             , const double & startAngle_
             , const double & spanAngle_
             )
-            : pen( pen_ )
-            , brush( brush_ )
+            : pen( std::move( pen_ ) )
+            , brush( std::move( brush_ ) )
             , rect( rect_ )
             , startAngle( startAngle_ )
             , spanAngle( spanAngle_ )
@@ -135,14 +186,14 @@ namespace sani {
     {
         DrawChord() {};
         DrawChord
-            ( const QPen & pen_
-            , const QBrush & brush_
+            ( QPen pen_
+            , QBrush brush_
             , const QRectF & rect_
             , const double & startAngle_
             , const double & spanAngle_
             )
-            : pen( pen_ )
-            , brush( brush_ )
+            : pen( std::move( pen_ ) )
+            , brush( std::move( brush_ ) )
             , rect( rect_ )
             , startAngle( startAngle_ )
             , spanAngle( spanAngle_ )
@@ -158,15 +209,15 @@ namespace sani {
     {
         DrawRoundedRect() {};
         DrawRoundedRect
-            ( const QPen & pen_
-            , const QBrush & brush_
+            ( QPen pen_
+            , QBrush brush_
             , const QRectF & rect_
             , const double & xRadius_
             , const double & yRadius_
             , const bool absolute_
             )
-            : pen( pen_ )
-            , brush( brush_ )
+            : pen( std::move( pen_ ) )
+            , brush( std::move( brush_ ) )
             , rect( rect_ )
             , xRadius( xRadius_ )
             , yRadius( yRadius_ )
@@ -184,44 +235,227 @@ namespace sani {
     {
         DrawPoint() {};
         DrawPoint
-            ( const QPen & pen_
+            ( QPen pen_
             , const QPointF & p_
             )
-            : pen( pen_ )
+            : pen( std::move( pen_ ) )
             , p( p_ )
         {
         }
         QPen pen;
         QPointF p;
     };
+    struct DrawingBounds;
+
+    // A write-once cache of the bounds of a composite drawing that is filled
+    // in lazily by 'sani::drawingBounds'. It may be filled concurrently from
+    // several threads. Copies start out empty.
+    class BoundsCache
+    {
+    public:
+        BoundsCache();
+        BoundsCache( const BoundsCache & );
+        BoundsCache & operator=( const BoundsCache & );
+        ~BoundsCache();
+
+        // Return the cached bounds or 0 if there are none yet.
+        const DrawingBounds * get() const;
+
+        // Cache the specified 'bounds' unless another value was cached first,
+        // and return the cached value.
+        const DrawingBounds & set( const DrawingBounds & bounds ) const;
+    private:
+        mutable std::atomic< const DrawingBounds * > m_bounds;
+    };
+
+    // The composite drawings below refer to their children through shared,
+    // immutable nodes. Copying a composite drawing, or wrapping an existing
+    // drawing in a new composite, therefore never copies a subtree.
     template< typename Drawing >
     struct DrawOverG
     {
-        DrawOverG(){}
-        DrawOverG( const Drawing & d1_, const Drawing & d2_ )
-            : d1( d1_ )
-            , d2( d2_ )
+        DrawOverG()
+            : d1( std::make_shared< const Drawing >() )
+            , d2( std::make_shared< const Drawing >() )
+        {
+        }
+        DrawOverG( Drawing d1_, Drawing d2_ )
+            : d1( std::make_shared< const Drawing >( std::move( d1_ ) ) )
+            , d2( std::make_shared< const Drawing >( std::move( d2_ ) ) )
         {
         }
-        Drawing d1;
-        Drawing d2;
+        DrawOverG
+            ( std::shared_ptr< const Drawing > d1_
+            , std::shared_ptr< const Drawing > d2_
+            )
+            : d1( std::move( d1_ ) )
+            , d2( std::move( d2_ ) )
+        {
+        }
+        std::shared_ptr< const Drawing > d1;
+        std::shared_ptr< const Drawing > d2;
+        BoundsCache boundsCache;
     };
     template< typename Drawing >
     struct DrawTransformG
     {
-        DrawTransformG(){}
-        DrawTransformG( const QTransform & t_, const Drawing & d_ )
+        DrawTransformG()
+            : d( std::make_shared< const Drawing >() )
+        {
+        }
+        DrawTransformG( const QTransform & t_, Drawing d_ )
+            : t( t_ )
+            , d( std::make_shared< const Drawing >( std::move( d_ ) ) )
+        {
+        }
+        DrawTransformG
+            ( const QTransform & t_
+            , std::shared_ptr< const Drawing > d_
+            )
             : t( t_ )
-            , d( d_ )
+            , d( std::move( d_ ) )
         {
         }
         QTransform t;
-        Drawing d;
+        std::shared_ptr< const Drawing > d;
+        BoundsCache boundsCache;
+    };
+    // A drawing that paints each of 'children' in order, each one over the
+    // ones before it. See 'drawAll'.
+    template< typename Drawing >
+    struct DrawGroupG
+    {
+        DrawGroupG()
+            : children( std::make_shared< const std::vector< Drawing > >() )
+        {
+        }
+        explicit DrawGroupG( std::vector< Drawing > children_ )
+            : children
+                ( std::make_shared< const std::vector< Drawing > >
+                    ( std::move( children_ ) )
+                )
+        {
+        }
+        std::shared_ptr< const std::vector< Drawing > > children;
+        BoundsCache boundsCache;
+    };
+    // A drawing that is painted through a raster image cache. 'hash' is the
+    // structural hash of 'd' (see 'sani_drawinghash') and identifies the
+    // cached image. See 'cachedDrawing'.
+    template< typename Drawing >
+    struct DrawCachedG
+    {
+        DrawCachedG()
+            : d( std::make_shared< const Drawing >() )
+            , hash( 0 )
+        {
+        }
+        DrawCachedG( Drawing d_, std::size_t hash_ )
+            : d( std::make_shared< const Drawing >( std::move( d_ ) ) )
+            , hash( hash_ )
+        {
+        }
+        DrawCachedG( std::shared_ptr< const Drawing > d_, std::size_t hash_ )
+            : d( std::move( d_ ) )
+            , hash( hash_ )
+        {
+        }
+        std::shared_ptr< const Drawing > d;
+        std::size_t hash;
+    };
+    // A drawing that paints the template drawing 'd' once for every element
+    // of 'transforms', each time transformed by that element. If 'colors' is
+    // not empty it holds one colour per instance, which replaces the colour of
+    // every pen and brush of the template for that instance. Instances are
+    // painted in order, so later ones are drawn over earlier ones. See
+    // 'drawInstances'.
+    template< typename Drawing >
+    struct DrawInstancesG
+    {
+        DrawInstancesG()
+            : d( std::make_shared< const Drawing >() )
+            , transforms
+                ( std::make_shared< const std::vector< QTransform > >() )
+            , colors( std::make_shared< const std::vector< QColor > >() )
+        {
+        }
+        DrawInstancesG
+            ( Drawing d_
+            , std::vector< QTransform > transforms_
+            , std::vector< QColor > colors_
+            )
+            : d( std::make_shared< const Drawing >( std::move( d_ ) ) )
+            , transforms
+                ( std::make_shared< const std::vector< QTransform > >
+                    ( std::move( transforms_ ) )
+                )
+            , colors
+                ( std::make_shared< const std::vector< QColor > >
+                    ( std::move( colors_ ) )
+                )
+        {
+        }
+        std::shared_ptr< const Drawing > d;
+        std::shared_ptr< const std::vector< QTransform > > transforms;
+        std::shared_ptr< const std::vector< QColor > > colors;
+        BoundsCache boundsCache;
+    };
+    // A drawing that paints one of several alternative drawings of the same
+    // thing, chosen by the scale at which it appears on the device.
+    // 'levels' is ordered from the most to the least detailed alternative,
+    // and 'minScales[ i ]', in device pixels per unit, is the smallest scale
+    // at which 'levels[ i ]' is painted; the thresholds decrease. Nothing is
+    // painted below the last threshold. The behavior is undefined unless
+    // 'levels' and 'minScales' have the same size and 'minScales' is sorted
+    // in descending order; 'drawLOD' ensures both. See 'drawLOD'.
+    template< typename Drawing >
+    struct DrawLODG
+    {
+        DrawLODG()
+            : levels( std::make_shared< const std::vector< Drawing > >() )
+            , minScales( std::make_shared< const std::vector< double > >() )
+        {
+        }
+        DrawLODG
+            ( std::vector< Drawing > levels_
+            , std::vector< double > minScales_
+            )
+            : levels
+                ( std::make_shared< const std::vector< Drawing > >
+                    ( std::move( levels_ ) )
+                )
+            , minScales
+                ( std::make_shared< const std::vector< double > >
+                    ( std::move( minScales_ ) )
+                )
+        {
+            assert( levels->size() == minScales->size() );
+            assert
+                ( std::is_sorted
+                    ( minScales->begin()
+                    , minScales->end()
+                    , std::greater< double >()
+                    )
+                );
+        }
+        std::shared_ptr< const std::vector< Drawing > > levels;
+        std::shared_ptr< const std::vector< double > > minScales;
+        BoundsCache boundsCache;
     };
     struct DrawNothing
     {
     };
 
+    struct Drawing;
+    namespace detail
+    {
+        // Release the children of the specified composite 'd', which is
+        // being destroyed. The nodes that are owned by nothing else are
+        // destroyed one after another rather than from within each other's
+        // destructors.
+        void releaseChildren( Drawing & d );
+    }
+
     struct Drawing
         : boost::variant
             < DrawPoint
@@ -234,8 +468,12 @@ namespace sani {
             , DrawPie
             , DrawChord
             , DrawNothing
-            , boost::recursive_wrapper< DrawOverG< Drawing > >
-            , boost::recursive_wrapper< DrawTransformG< Drawing > >
+            , DrawOverG< Drawing >
+            , DrawTransformG< Drawing >
+            , DrawCachedG< Drawing >
+            , DrawInstancesG< Drawing >
+            , DrawGroupG< Drawing >
+            , DrawLODG< Drawing >
             >
     {
         typedef boost::variant
@@ -249,14 +487,23 @@ namespace sani {
             , DrawPie
             , DrawChord
             , DrawNothing
-            , boost::recursive_wrapper< DrawOverG< Drawing > >
-            , boost::recursive_wrapper< DrawTransformG< Drawing > >
+            , DrawOverG< Drawing >
+            , DrawTransformG< Drawing >
+            , DrawCachedG< Drawing >
+            , DrawInstancesG< Drawing >
+            , DrawGroupG< Drawing >
+            , DrawLODG< Drawing >
             > Base;
 
         Drawing(){}
         template< typename T >
-        Drawing( const T & t )
-            : Base( t )
+        Drawing
+            ( T && t
+            , typename std::enable_if
+                < !std::is_same< typename std::decay< T >::type, Drawing >::value
+                >::type * = 0
+            )
+            : Base( std::forward< T >( t ) )
         {
         }
         Drawing& operator=(const Drawing& other)
@@ -269,55 +516,154 @@ namespace sani {
             : Base(static_cast<const Base&>(other))
         {
         }
+        // The user-declared copy operations above suppress the implicit move
+        // operations, so they are declared explicitly.
+        Drawing& operator=(Drawing&& other)
+            BOOST_NOEXCEPT_IF(std::is_nothrow_move_assignable<Base>::value)
+        {
+            *static_cast<Base*>(this) = static_cast<Base&&>(other);
+            return(*this);
+        }
+        Drawing(Drawing&& other)
+            BOOST_NOEXCEPT_IF(std::is_nothrow_move_constructible<Base>::value)
+            : Base(static_cast<Base&&>(other))
+        {
+        }
+        ~Drawing()
+        {
+            // 'DrawOverG' is the first of the composite nodes, which are the
+            // only ones that own children.
+            typedef boost::mpl::distance
+                < boost::mpl::begin< Base::types >::type
+                , boost::mpl::find< Base::types, DrawOverG< Drawing > >::type
+                > FirstComposite;
+            if( which() >= FirstComposite::value )
+                detail::releaseChildren( *this );
+        }
     };
     typedef DrawOverG<Drawing> DrawOver;
     typedef DrawTransformG<Drawing> DrawTransform;
+    typedef DrawCachedG<Drawing> DrawCached;
+    typedef DrawInstancesG<Drawing> DrawInstances;
+    typedef DrawGroupG<Drawing> DrawGroup;
+    typedef DrawLODG<Drawing> DrawLOD;
 
-    Drawing drawLine( const QPen & pen, const QPointF & p1, const QPointF & p2 );
-    Drawing drawPoint( const QPen & pen, const QPointF & p );
-    Drawing drawRect( const QPen & pen, const QBrush & brush, const QRectF & rect );
-    Drawing drawEllipse( const QPen & pen, const QBrush & brush, const QRectF & rect );
+    Drawing drawLine( QPen pen, const QPointF & p1, const QPointF & p2 );
+    Drawing drawPoint( QPen pen, const QPointF & p );
+    Drawing drawRect( QPen pen, QBrush brush, const QRectF & rect );
+    Drawing drawEllipse( QPen pen, QBrush brush, const QRectF & rect );
     Drawing drawRoundedRect
-        ( const QPen & pen
-        , const QBrush & brush
+        ( QPen pen
+        , QBrush brush
         , const QRectF & rect
         , const double & xRadius
         , const double & yRadius
         , const bool absolute
         );
     Drawing drawText
-        ( const QPen & pen
-        , const QBrush & brush
-        , const QFont & font
+        ( QPen pen
+        , QBrush brush
+        , QFont font
         , const QPointF & position
-        , const std::string & text
+        , std::string text
         );
     Drawing drawArc
-        ( const QPen & pen
-        , const QBrush & brush
+        ( QPen pen
+        , QBrush brush
         , const QRectF & rect
         , const double & startAngle
         , const double & spanAngle
         );
     Drawing drawPie
-        ( const QPen & pen
-        , const QBrush & brush
+        ( QPen pen
+        , QBrush brush
         , const QRectF & rect
         , const double & startAngle
         , const double & spanAngle
         );
     Drawing drawChord
-        ( const QPen & pen
-        , const QBrush & brush
+        ( QPen pen
+        , QBrush brush
         , const QRectF & rect
         , const double & startAngle
         , const double & spanAngle
         );
-    Drawing transformDrawing( const QTransform & t, const Drawing & d );
-    Drawing drawOver( const Drawing & a, const Drawing & b );
+    Drawing transformDrawing( const QTransform & t, Drawing d );
+    Drawing drawOver( Drawing a, Drawing b );
+
+    // Return a drawing that paints every element of the specified 'ds' in
+    // order, each one over the ones before it, so that 'drawAll({ b, a })'
+    // paints like 'drawOver( a, b )'. Unlike nested 'drawOver' calls this
+    // creates a single node however many elements there are.
+    Drawing drawAll( std::vector< Drawing > ds );
+
+    // Return a drawing that paints every element of the specified 'range' in
+    // order like the above.
+    template< typename Range >
+    Drawing drawAll( const Range & range )
+    {
+        return drawAll
+            ( std::vector< Drawing >( boost::begin( range ), boost::end( range ) )
+            );
+    }
+
+    // Return a drawing that looks like the specified 'd' but is rasterized
+    // into an image the first time it is painted at a given scale, and is
+    // painted by drawing that image afterwards. Separately built drawings that
+    // are structurally equal share the cached images. This is worthwhile for
+    // complex, static drawings that are moved around, e.g. with
+    // 'transformDrawing'.
+    Drawing cachedDrawing( Drawing d );
+
+    // Return a drawing that paints the specified 'd' once for every element of
+    // the specified 'transforms', transformed by that element, without
+    // building a node per instance. If the specified 'colors' is not empty,
+    // the pens and brushes of the instance with index 'i' have the colour
+    // 'colors[i]'. The behavior is undefined unless 'colors' is empty or has
+    // as many elements as 'transforms'. This is much cheaper than combining
+    // transformed copies of 'd' with 'drawOver' when there are many instances,
+    // e.g. markers in a scatter plot.
+    Drawing drawInstances
+        ( Drawing d
+        , std::vector< QTransform > transforms
+        , std::vector< QColor > colors = std::vector< QColor >()
+        );
+
+    // Return a drawing that paints, out of the specified 'levels', the
+    // drawing whose threshold is the largest one not above the scale at which
+    // the drawing appears on the device, in device pixels per unit, and
+    // nothing if all thresholds are above it. E.g. a symbol can be drawn in
+    // full detail when zoomed in and as a filled rectangle when it shrinks to
+    // a few pixels:
+    //..
+    //  drawLOD( { { 4.0, detailed }, { 0.0, drawRect( pen, brush, box ) } } )
+    //..
+    Drawing drawLOD( std::vector< std::pair< double, Drawing > > levels );
+
+    // Return the level of the specified 'd' that is painted at the specified
+    // 'scale', or 0 if there is none.
+    const Drawing * lodLevel( const DrawLOD & d, double scale );
+
+    // Return the scale, in device pixels per unit, at which a drawing painted
+    // with the specified 'toDevice' transform appears, i.e. the square root
+    // of the factor by which 'toDevice' scales areas.
+    double lodScale( const QTransform & toDevice );
     const Drawing drawNothing = DrawNothing();
 
+    // Draw the specified 'd' using the specified 'painter'. The world
+    // transform of 'painter' is restored afterwards, but its pen, brush, and
+    // font are left as set by the last primitive painted.
     void draw( const Drawing & d, QPainter & painter );
+
+    // Draw the specified 'd' using the specified 'painter' like the above, but
+    // skip every subtree that lies entirely outside of the specified
+    // 'exposedRect', given in the current logical coordinates of 'painter',
+    // or outside of the clip region of 'painter'.
+    void draw
+        ( const Drawing & d
+        , QPainter & painter
+        , const QRectF & exposedRect
+        );
 }
 
 #endif
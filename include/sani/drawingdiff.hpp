@@ -0,0 +1,66 @@
+#ifndef SANI_DRAWINGDIFF_HPP_
+#define SANI_DRAWINGDIFF_HPP_
+
+//@PURPOSE: Provide the regions that differ between two 'Drawing's
+//
+//@CLASSES:
+//
+//@SEE_ALSO: sani_boundingrect, sani_interactiveanimationview
+//
+//@DESCRIPTION: This component provides a function, 'changedBounds', that
+// compares two drawings, typically consecutive frames of an animation, and
+// returns the bounds of the subtrees that differ between them. Repainting
+// those regions of the first drawing with the second one produces the same
+// picture as repainting everything.
+//
+// The two drawings are walked in lockstep. Subtrees that are shared between
+// them, which is common when an animation wraps unchanged drawings in new
+// composite nodes, are recognized by identity and never visited. Composite
+// nodes of the same kind (and, for 'DrawTransform', with the same matrix, and
+// for 'DrawGroup', with as many children) are compared child by child. Any
+// other pair of subtrees that is not equal is reported as changed with the
+// bounds of both subtrees.
+//
+// The test used for such pairs is also provided as 'shallowEqual': it compares
+// primitives by value and composite nodes by their attributes and the
+// identity of their children, so it never walks a subtree. 'structurallyEqual'
+// compares whole subtrees instead, skipping the parts they share.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Invalidate the parts of a scene that changed
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// for (const sani::DrawingBounds& bounds :
+//      sani::changedBounds(previousFrame, nextFrame))
+//   scene.invalidate(bounds.rect, QGraphicsScene::BackgroundLayer);
+//..
+
+#include <sani/boundingrect.hpp>
+#include <sani/drawing.hpp>
+
+#include <vector>
+
+namespace sani {
+
+// Return the bounds, in the coordinates of the specified 'before' and 'after'
+// drawings, of every subtree that differs between 'before' and 'after'. No
+// element of the result is empty.
+std::vector<DrawingBounds> changedBounds(const Drawing& before,
+                                         const Drawing& after);
+
+// Return 'true' if the specified 'a' and 'b' are primitives of the same kind
+// with equal attributes, or composite nodes of the same kind with equal
+// attributes that share their children, and 'false' otherwise. If 'true' is
+// returned, 'a' and 'b' paint the same.
+bool shallowEqual(const Drawing& a, const Drawing& b);
+
+// Return 'true' if the specified 'a' and 'b' have the same structure and
+// their corresponding primitives and composite nodes have equal attributes,
+// and 'false' otherwise.
+bool structurallyEqual(const Drawing& a, const Drawing& b);
+}
+
+#endif
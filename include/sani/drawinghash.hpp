@@ -0,0 +1,42 @@
+#ifndef SANI_DRAWINGHASH_HPP_
+#define SANI_DRAWINGHASH_HPP_
+
+//@PURPOSE: Provide a structural hash of 'Drawing's
+//
+//@CLASSES:
+//
+//@SEE_ALSO: sani_drawing
+//
+//@DESCRIPTION: This component provides a function, 'hash_value', that
+// computes a hash of a 'Drawing' from its structure and the values of all its
+// primitives, including their pens, brushes, and fonts. Drawings that are
+// built separately but paint the same thing the same way have equal hashes.
+// Following the Boost convention, 'boost::hash<sani::Drawing>' uses it.
+//
+// The hash visits every node of the drawing, except that the children of
+// 'DrawCached' nodes are not visited again since those nodes store their
+// hash.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Hash two separately built drawings
+// - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// const sani::Drawing a = sani::drawRect(QPen(), QBrush(Qt::red), rect);
+// const sani::Drawing b = sani::drawRect(QPen(), QBrush(Qt::red), rect);
+// assert(sani::hash_value(a) == sani::hash_value(b));
+//..
+
+#include <sani/drawing.hpp>
+
+#include <cstddef>
+
+namespace sani {
+
+// Return the structural hash of the specified 'd'.
+std::size_t hash_value(const Drawing& d);
+}
+
+#endif
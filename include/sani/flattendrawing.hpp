@@ -0,0 +1,45 @@
+#ifndef SANI_FLATTENDRAWING_HPP_
+#define SANI_FLATTENDRAWING_HPP_
+
+//@PURPOSE: Provide a rewrite of nested 'DrawOver' chains into 'DrawGroup's
+//
+//@CLASSES:
+//
+//@SEE_ALSO: sani_drawing, sani_rewritedrawing
+//
+//@DESCRIPTION: This component provides a function, 'flattenDrawing', that
+// replaces every tree of directly nested 'DrawOver' and 'DrawGroup' nodes in
+// a 'Drawing' by a single 'DrawGroup' that holds the operands of the tree in
+// painting order. Composing N drawings with 'drawOver' creates a chain of N
+// nodes; after flattening it is a single node with a contiguous array of N
+// children, which is cheaper to walk and to diff child by child.
+//
+// The result paints exactly like the original drawing and shares the subtrees
+// that contain no 'DrawOver' chain with it, as described in
+// 'sani_rewritedrawing'. The children of 'DrawCached' nodes are left as they
+// are since they are painted from a cached image anyway.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Flatten a scene built with 'drawOver'
+// - - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::Drawing scene = sani::drawNothing;
+// for (const Marker& marker : markers)
+//   scene = sani::drawOver(marker.drawing(), scene);
+// scene = sani::flattenDrawing(scene);
+//..
+
+#include <sani/drawing.hpp>
+
+namespace sani {
+
+// Return a drawing that paints like the specified 'd' in which every tree of
+// directly nested 'DrawOver' and 'DrawGroup' nodes is replaced by a single
+// 'DrawGroup'.
+Drawing flattenDrawing(const Drawing& d);
+}
+
+#endif
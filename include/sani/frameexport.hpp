@@ -0,0 +1,125 @@
+#ifndef SANI_FRAMEEXPORT_HPP_
+#define SANI_FRAMEEXPORT_HPP_
+
+//@PURPOSE: Provide parallel offline export of animation frames to files
+//
+//@CLASSES:
+//  sani::FrameExportSettings: the frames, format, and files of an export
+//
+//@SEE_ALSO: sani_animation, sani_offscreenrenderer, sani_tileddraw
+//
+//@DESCRIPTION: This component provides functions that render the frames of an
+// 'Animation' over a time range at a fixed frame rate and write each one to a
+// file, either as a PNG image or as an SVG document, as fast as the machine
+// allows rather than in real time. The frames, their size and transform, and
+// the names of the files are described by a 'FrameExportSettings' object.
+//
+// Rendering and encoding the frames, which is usually the bulk of the work,
+// is done concurrently by the threads of the global 'QThreadPool' and the
+// calling thread. How frames are pulled depends on the function:
+//
+//: 'exportFrames': The animation is pulled on the calling thread, at
+//:   increasing times, as by a view. The pulled frames wait for the encoders
+//:   in a queue of at most 'maxQueuedFrames' frames; when it is full the
+//:   calling thread encodes a frame itself instead of pulling the next one,
+//:   which bounds the memory used and keeps the export going even if no pool
+//:   thread is idle.
+//:
+//: 'exportIndependentFrames': Every thread creates its own instance of the
+//:   animation and pulls the frames it encodes, so pulling is parallel, too.
+//:   This requires that the frame of the animation at a time does not depend
+//:   on the times at which it was pulled before, which holds for most
+//:   animations that do not integrate or accumulate state.
+//
+// Frames are painted the way 'OffscreenRenderer' paints them, on a
+// background of 'background'. The export ends early when the animation ends;
+// frames after its end are not written.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Export a minute of an incident replay as a PNG sequence
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::FrameExportSettings settings;
+// settings.endTime = 60.0;
+// settings.frameRate = 30.0;
+// settings.size = QSize(1920, 1080);
+// settings.transform = QTransform::fromScale(100.0, 100.0);
+// settings.fileNamePattern = "replay/frame%1.png";
+// if (!sani::exportFrames(replay, settings))
+//   qWarning() << "export failed";
+//..
+
+#include <sani/animation.hpp>
+
+#include <boost/function.hpp>
+#include <QColor>
+#include <QPainter>
+#include <QSize>
+#include <QString>
+#include <QTransform>
+#include <cstddef>
+
+namespace sani {
+
+// This class implements a value-semantic description of an export of the
+// frames of an animation.
+struct FrameExportSettings {
+  // The formats frames can be written in
+  enum Format { e_PNG, e_SVG };
+
+  // Create a 'FrameExportSettings' object describing an empty export of
+  // 640x480 PNG images at 30 frames per second.
+  FrameExportSettings()
+      : startTime(0.0),
+        endTime(0.0),
+        frameRate(30.0),
+        size(640, 480),
+        background(Qt::white),
+        renderHints(QPainter::Antialiasing),
+        format(e_PNG),
+        fileNamePattern("frame%1.png"),
+        indexDigits(6),
+        maxQueuedFrames(16) {}
+
+  double startTime;  // Time of the first frame in seconds
+  double endTime;    // Time in seconds before which the last frame is. The
+                     // frames are at 'startTime + i / frameRate' for every
+                     // 'i' such that this is less than 'endTime'.
+  double frameRate;  // Frames per second. Must be positive.
+
+  QSize size;            // Size of the frames in pixels
+  QTransform transform;  // Transform from drawing coordinates to pixels
+  QColor background;     // Color the frames are filled with before painting
+  QPainter::RenderHints renderHints;  // Hints the frames are painted with
+
+  Format format;             // Format the frames are written in
+  QString fileNamePattern;   // Name of the file of a frame, in which '%1'
+                             // stands for the index 'i' of the frame
+  int indexDigits;           // Number of digits 'i' is padded to with zeros
+  std::size_t maxQueuedFrames;  // Number of pulled frames that may wait for
+                                // an encoder. Must be positive.
+};
+
+// Write the frames of the specified 'animation' described by the specified
+// 'settings' to files, pulling 'animation' on the calling thread. Return
+// 'true' if every frame up to the end of the range or of the animation was
+// written, and 'false' otherwise.
+bool exportFrames(const Animation& animation,
+                  const FrameExportSettings& settings);
+
+// Write the frames described by the specified 'settings' of the animations
+// returned by the specified 'makeAnimation' to files, calling 'makeAnimation'
+// once on every thread taking part and pulling each animation only from the
+// thread that created it. Return 'true' if every frame up to the end of the
+// range or of the animation was written, and 'false' otherwise. The behavior
+// is undefined unless all animations returned by 'makeAnimation' have the
+// same frame at every time, whatever times they were pulled at before, and
+// 'makeAnimation' may be called from several threads at once.
+bool exportIndependentFrames(const boost::function<Animation()>& makeAnimation,
+                             const FrameExportSettings& settings);
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef SANI_FRAMESAMPLER_HPP_
+#define SANI_FRAMESAMPLER_HPP_
+
+//@PURPOSE: Provide a worker thread that pulls frames from an 'Animation'
+//
+//@CLASSES:
+//  sani::FrameSampler: pulls an animation ahead of time on its own thread
+//
+//@SEE_ALSO: sani_interactiveanimationview, sani_triplebuffer
+//
+//@DESCRIPTION: This component provides a class, 'FrameSampler', that owns a
+// thread on which an 'Animation' is pulled. The owner requests a frame for a
+// future presentation time with 'requestFrame', keeps painting the current
+// frame meanwhile, and later picks up the finished frame with 'takeFrame'.
+// Pulling the animation and painting thus overlap instead of taking turns.
+//
+// Finished frames are handed over through a 'TripleBuffer', so neither thread
+// waits for the other. A request that is made before the previous one was
+// started replaces it, and a finished frame that was not taken before the
+// next one finished is dropped.
+//
+// Since an animation must only be used by one thread at a time, everything
+// that feeds it, typically the functions that notify its user input
+// behaviors, must be passed to 'post' instead of being called directly. The
+// posted functions are called on the sampling thread, in order, before the
+// next frame is pulled.
+//
+// With optimization enabled, every pulled frame is also passed through
+// 'optimizeDrawing' (see 'sani_optimizedrawing') on the sampling thread, so
+// the optimization overlaps with painting as well.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Present frames pulled one tick ahead
+// - - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::FrameSampler sampler(animation);
+// sampler.requestFrame(0.0);
+//
+// // On every tick at time 'now'
+// if (boost::optional<sani::FrameSampler::Frame> opFrame =
+//         sampler.takeFrame())
+//   present(opFrame->opDrawing);
+// sampler.requestFrame(now + tickInterval);
+//..
+
+#include <sani/animation.hpp>
+#include <sani/triplebuffer.hpp>
+
+#include <boost/function.hpp>
+#include <boost/optional.hpp>
+#include <QtGlobal>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sani {
+
+// This class implements a thread that pulls frames from an 'Animation'.
+class FrameSampler {
+ public:
+  // A frame pulled from the animation
+  struct Frame {
+    Frame() : time(0.0), pullNsecs(0) {}
+
+    boost::optional<Drawing> opDrawing;  // 'boost::none' once the animation
+                                         // has ended
+    double time;                         // Time the frame was pulled at
+    qint64 pullNsecs;                    // Time spent pulling and
+                                         // optimizing it
+  };
+
+  // Create a 'FrameSampler' object that pulls the specified 'animation' on a
+  // new thread. No frame is pulled until one is requested.
+  explicit FrameSampler(const Animation& animation);
+
+  // Wait for the frame being pulled, if any, and stop the thread.
+  ~FrameSampler();
+
+  // Request the frame at the specified 'time', replacing any request that
+  // has not been started yet.
+  void requestFrame(double time);
+
+  // Call the specified 'input' on the sampling thread before the next frame
+  // is pulled.
+  void post(const boost::function<void()>& input);
+
+  // Set whether frames pulled from now on are optimized with
+  // 'optimizeDrawing' to the specified 'enabled'. The default is 'false'.
+  void setOptimization(bool enabled);
+
+  // Return the most recently finished frame if it was not returned before,
+  // and 'boost::none' otherwise.
+  boost::optional<Frame> takeFrame();
+
+ private:
+  FrameSampler(const FrameSampler&);
+  FrameSampler& operator=(const FrameSampler&);
+
+  // Pull requested frames until stopped.
+  void run();
+
+  Animation m_animation;  // Only used by the sampling thread
+  TripleBuffer<Frame> m_frames;
+
+  std::mutex m_mutex;  // Guards the members below
+  std::condition_variable m_wake;
+  boost::optional<double> m_opRequestedTime;
+  std::vector<boost::function<void()> > m_inputs;
+  bool m_optimize;
+  bool m_stop;
+
+  std::thread m_thread;  // Started last
+};
+}
+
+#endif
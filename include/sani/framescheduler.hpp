@@ -0,0 +1,112 @@
+#ifndef SANI_FRAMESCHEDULER_HPP_
+#define SANI_FRAMESCHEDULER_HPP_
+
+//@PURPOSE: Provide the clocks that decide when views produce frames
+//
+//@CLASSES:
+//  sani::FrameScheduler: protocol for sources of frame ticks
+//  sani::TimerFrameScheduler: frame ticks at a fixed rate from a timer
+//
+//@SEE_ALSO: sani_interactiveanimationview
+//
+//@DESCRIPTION: This component provides a protocol class, 'FrameScheduler',
+// whose implementations emit 'frameDue' whenever a view should pull and paint
+// a new frame, and a concrete implementation, 'TimerFrameScheduler', that
+// does so at a configurable rate.
+//
+// 'TimerFrameScheduler' keeps a grid of deadlines, one per frame interval,
+// anchored at the time it is started. It arms a precise single-shot timer for
+// the next deadline only after the previous frame has been handled. A frame
+// that overruns its budget therefore never causes a backlog of timer events:
+// the deadlines that passed meanwhile are skipped and reported as
+// 'missedFrames' of the next tick. Since other events are processed between
+// ticks, the handler of 'frameDue' does not need to process events itself.
+//
+// A rate of 0 selects the refresh rate of the primary screen, or 60 Hz if it
+// is unknown. Ticks are then as frequent as the display refreshes, but they
+// are not phase-locked to its vertical blank.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Run a view at 30 frames per second
+// - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::InteractiveAnimationView view;
+// view.setFrameScheduler(std::unique_ptr<sani::FrameScheduler>(
+//     new sani::TimerFrameScheduler(30.0)));
+//..
+
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QObject>
+
+namespace sani {
+
+// This protocol class describes a source of frame ticks.
+class FrameScheduler : public QObject {
+  Q_OBJECT
+ public:
+  virtual ~FrameScheduler();
+
+  // Start emitting 'frameDue'. Do nothing if already started.
+  virtual void start() = 0;
+
+  // Stop emitting 'frameDue'.
+  virtual void stop() = 0;
+
+  // Return 'true' if 'frameDue' is being emitted, and 'false' otherwise.
+  virtual bool isActive() const = 0;
+
+  // Return the time between consecutive ticks in nanoseconds, which is the
+  // time budget of a frame.
+  virtual qint64 intervalNsecs() const = 0;
+
+Q_SIGNALS:
+  // This signal is emitted when a frame should be produced. The specified
+  // 'missedFrames' is the number of ticks that were skipped since the
+  // previous one because a frame overran its budget.
+  void frameDue(int missedFrames);
+};
+
+// This class implements a 'FrameScheduler' that ticks at a fixed rate.
+class TimerFrameScheduler : public FrameScheduler {
+  Q_OBJECT
+ public:
+  // Create an inactive 'TimerFrameScheduler' object that ticks at the
+  // specified 'rateHz', or at the refresh rate of the primary screen if
+  // 'rateHz' is 0.
+  explicit TimerFrameScheduler(double rateHz = 60.0);
+
+  // Set the rate of the ticks to the specified 'rateHz', or to the refresh
+  // rate of the primary screen if 'rateHz' is 0. The grid of deadlines is
+  // restarted if the scheduler is active.
+  void setRate(double rateHz);
+
+  // Return the rate of the ticks in Hz.
+  double rate() const;
+
+  void start() override;
+  void stop() override;
+  bool isActive() const override;
+  qint64 intervalNsecs() const override;
+
+ protected:
+  // Emit 'frameDue' and arm the timer for the next deadline.
+  void timerEvent(QTimerEvent* event) override;
+
+ private:
+  // Arm the timer for the next deadline that lies in the future.
+  void scheduleNextTick();
+
+  QBasicTimer m_timer;
+  QElapsedTimer m_clock;       // Started at the first deadline
+  qint64 m_intervalNsecs;
+  qint64 m_nextDeadlineNsecs;  // Relative to the start of 'm_clock'
+  int m_missedFrames;          // Skipped since the last tick
+  bool m_active;
+};
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef SANI_FRAMESTATISTICS_HPP_
+#define SANI_FRAMESTATISTICS_HPP_
+
+//@PURPOSE: Provide statistics about the time spent rendering frames
+//
+//@CLASSES:
+//  sani::FrameTiming: time spent pulling and painting one frame
+//  sani::RollingHistogram: histogram of the most recent durations
+//  sani::FrameStatistics: rolling timing statistics of a stream of frames
+//
+//@SEE_ALSO: sani_interactiveanimationview, sani_offscreenrenderer
+//
+//@DESCRIPTION: This component provides classes that describe where the time
+// of rendering an animation goes. A 'FrameTiming' holds the time spent pulling
+// one frame from its 'Animation' and the time spent painting it. A
+// 'FrameStatistics' object accumulates 'FrameTiming's, together with the
+// interval between consecutive frames, into three 'RollingHistogram's and
+// counts the frames that missed the frame budget.
+//
+// A frame is "over budget" when pulling and painting it together took longer
+// than the budget, which points at the animation or at painting. A frame is
+// "late" when it started more than one and a half budgets after the previous
+// one, i.e. at least one frame was skipped; a late frame that is not over
+// budget points at the event loop.
+//
+// All durations are in nanoseconds.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Report the 95th percentile of the paint time
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// const sani::FrameStatistics& statistics = view.frameStatistics();
+// qDebug() << "paint p95:" << statistics.paintTimes().quantile(0.95) / 1e6
+//          << "ms," << statistics.lateFrames() << "late frames";
+//..
+
+#include <QMetaType>
+#include <cstddef>
+#include <vector>
+
+namespace sani {
+
+// This class implements a value-semantic description of the time spent
+// rendering one frame.
+struct FrameTiming {
+  FrameTiming() : pullNsecs(0), paintNsecs(0) {}
+
+  qint64 pullNsecs;   // Time spent pulling the frame from the animation
+  qint64 paintNsecs;  // Time spent painting the frame
+};
+
+// This class implements a histogram of the most recently added durations.
+class RollingHistogram {
+ public:
+  // Create an empty 'RollingHistogram' object that covers the specified
+  // 'windowSize' most recent durations with the specified 'binCount' bins of
+  // the specified 'binWidthNsecs' each. The last bin also counts all longer
+  // durations. The behavior is undefined unless all arguments are positive.
+  RollingHistogram(std::size_t windowSize,
+                   qint64 binWidthNsecs,
+                   std::size_t binCount);
+
+  // Add the specified 'nsecs' duration, dropping the oldest one if the window
+  // is full.
+  void add(qint64 nsecs);
+
+  // Remove all durations.
+  void clear();
+
+  // Return the number of durations in each bin. Bin 'i' counts durations in
+  // '[i * binWidthNsecs(), (i + 1) * binWidthNsecs())'.
+  const std::vector<std::size_t>& bins() const { return m_bins; }
+
+  // Return the width of each bin.
+  qint64 binWidthNsecs() const { return m_binWidthNsecs; }
+
+  // Return the number of durations in the window.
+  std::size_t size() const { return m_size; }
+
+  // Return the smallest duration in the window that is at least as long as
+  // the specified 'q' fraction of them, or 0 if the window is empty.
+  qint64 quantile(double q) const;
+
+  // Return the mean duration in the window, or 0 if it is empty.
+  qint64 mean() const;
+
+ private:
+  std::size_t binOf(qint64 nsecs) const;
+
+  std::vector<qint64> m_window;  // Ring buffer of the durations
+  std::size_t m_next;            // Index in 'm_window' of the next duration
+  std::size_t m_size;            // Number of durations in 'm_window'
+  qint64 m_sum;                  // Sum of the durations in 'm_window'
+  std::vector<std::size_t> m_bins;
+  qint64 m_binWidthNsecs;
+};
+
+// This class implements rolling timing statistics of a stream of frames.
+class FrameStatistics {
+ public:
+  // Create a 'FrameStatistics' object for frames with the specified
+  // 'budgetNsecs' that covers the 240 most recent frames with 1 ms bins up to
+  // 64 ms.
+  explicit FrameStatistics(qint64 budgetNsecs);
+
+  // Add a frame with the specified 'timing' that started the specified
+  // 'intervalNsecs' after the previous one. Pass 0 as 'intervalNsecs' for the
+  // first frame.
+  void addFrame(const FrameTiming& timing, qint64 intervalNsecs);
+
+  // Remove all frames and reset the counts.
+  void reset();
+
+  // Set the frame budget to the specified 'budgetNsecs'.
+  void setBudgetNsecs(qint64 budgetNsecs) { m_budgetNsecs = budgetNsecs; }
+
+  // Return the frame budget.
+  qint64 budgetNsecs() const { return m_budgetNsecs; }
+
+  // Return the histogram of the time spent pulling frames.
+  const RollingHistogram& pullTimes() const { return m_pullTimes; }
+
+  // Return the histogram of the time spent painting frames.
+  const RollingHistogram& paintTimes() const { return m_paintTimes; }
+
+  // Return the histogram of the intervals between consecutive frames.
+  const RollingHistogram& intervals() const { return m_intervals; }
+
+  // Return the number of frames added since the last reset.
+  std::size_t frames() const { return m_frames; }
+
+  // Return the number of frames, since the last reset, whose pull and paint
+  // times add up to more than the budget.
+  std::size_t overBudgetFrames() const { return m_overBudgetFrames; }
+
+  // Return the number of frames, since the last reset, that started more than
+  // one and a half budgets after the previous frame.
+  std::size_t lateFrames() const { return m_lateFrames; }
+
+ private:
+  qint64 m_budgetNsecs;
+  RollingHistogram m_pullTimes;
+  RollingHistogram m_paintTimes;
+  RollingHistogram m_intervals;
+  std::size_t m_frames;
+  std::size_t m_overBudgetFrames;
+  std::size_t m_lateFrames;
+};
+}
+
+Q_DECLARE_METATYPE(sani::FrameTiming)
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef SANI_GLRENDERER_HPP_
+#define SANI_GLRENDERER_HPP_
+
+//@PURPOSE: Provide an OpenGL painter of 'DisplayList's with batched geometry
+//
+//@CLASSES:
+//  sani::GlRenderer: paints display lists with vertex buffers where possible
+//
+//@SEE_ALSO: sani_displaylist, sani_interactiveanimationview
+//
+//@DESCRIPTION: This component provides a class, 'GlRenderer', that paints a
+// 'DisplayList' on a 'QPainter' whose paint engine is OpenGL, e.g. one that
+// paints on a 'QOpenGLWidget'. 'DrawPoint', 'DrawLine', 'DrawRect', and
+// 'DrawEllipse' primitives are tessellated into triangles, already mapped to
+// device coordinates, which are uploaded into a single vertex buffer and
+// drawn with one 'glDrawArrays' call per run of such primitives. All other
+// primitives, notably text, arcs, pies, and chords, are painted with the
+// 'QPainter', which ends the current run; painting order is preserved.
+//
+// Only primitives with a solid brush (or none) and a solid, opaque pen (or
+// none) are tessellated. Strokes are tessellated as overlapping pieces, which
+// cannot be told apart from a single outline only when the pen is opaque.
+// Anything else, as well as every primitive with a perspective transform,
+// falls back to the 'QPainter'.
+//
+// The geometry is drawn without antialiasing of its own; antialiasing comes
+// from multisampling of the target surface, if any.
+//
+// Only OpenGL 2.0 / OpenGL ES 2.0 features are used, so the renderer also
+// works with software implementations such as Mesa's llvmpipe.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Paint a frame in a 'QOpenGLWidget'
+// - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// void MyGlWidget::paintGL() {
+//   QPainter painter(this);
+//   m_renderer.draw(m_displayList, painter);
+// }
+//..
+
+#include <sani/displaylist.hpp>
+
+#include <memory>
+
+class QPainter;
+
+namespace sani {
+
+// This class implements a painter of 'DisplayList's that batches simple
+// primitives into OpenGL vertex buffers.
+class GlRenderer {
+ public:
+  // Create a 'GlRenderer' object. No OpenGL resources are created until the
+  // first call to 'draw'.
+  GlRenderer();
+
+  ~GlRenderer();
+
+  // Paint the specified 'displayList' using the specified 'painter'. The
+  // behavior is undefined unless 'isOpenGLPainter(painter)'.
+  void draw(const DisplayList& displayList, QPainter& painter);
+
+ private:
+  GlRenderer(const GlRenderer&);
+  GlRenderer& operator=(const GlRenderer&);
+
+  struct Impl;
+  const std::unique_ptr<Impl> m_impl;
+};
+
+// Return 'true' if the specified 'painter' paints with OpenGL, and 'false'
+// otherwise.
+bool isOpenGLPainter(const QPainter& painter);
+}
+
+#endif
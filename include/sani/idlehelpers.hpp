@@ -0,0 +1,47 @@
+#ifndef SANI_IDLEHELPERS_HPP_
+#define SANI_IDLEHELPERS_HPP_
+
+//@PURPOSE: Provide sharing work with the idle threads of the global pool
+//
+//@CLASSES:
+//
+//@SEE_ALSO: sani_tileddraw, sani_frameexport
+//
+//@DESCRIPTION: This component provides a function, 'runWithIdleHelpers', that
+// runs work on the calling thread while idle threads of the global
+// 'QThreadPool' help with it, and returns once all of them finished. Only
+// threads that are idle when the call starts are used, so a call from a pool
+// thread, or one made while the pool is busy, never waits for helpers that
+// cannot start; the calling thread then does all of the work alone. The work
+// must be divisible among any number of threads, e.g. by having every thread
+// take items from a shared queue until none is left.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Process a list of items in parallel
+// - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// std::atomic<std::size_t> next(0);
+// const boost::function<void()> work = [&] {
+//   for (std::size_t i = next++; i < items.size(); i = next++)
+//     process(items[i]);
+// };
+// sani::runWithIdleHelpers(items.size() - 1, work, work);
+//..
+
+#include <boost/function.hpp>
+#include <cstddef>
+
+namespace sani {
+
+// Run the specified 'work' on the calling thread and the specified 'help' on
+// up to the specified 'maxHelpers' idle threads of the global 'QThreadPool',
+// and return once every run finished.
+void runWithIdleHelpers(std::size_t maxHelpers,
+                        const boost::function<void()>& help,
+                        const boost::function<void()>& work);
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SANI_INPUTQUEUE_HPP_
+#define SANI_INPUTQUEUE_HPP_
+
+//@PURPOSE: Provide a queue that coalesces user input between frames
+//
+//@CLASSES:
+//  sani::InputQueue: collects 'InputEvent's and merges redundant mouse moves
+//
+//@SEE_ALSO: sani_userinput, sani_interactiveanimationview
+//
+//@DESCRIPTION: This component provides a class, 'InputQueue', that collects
+// the 'InputEvent's arriving between two frames so that they can be delivered
+// to an animation as one batch. A mouse move that directly follows another
+// mouse move replaces it, since only the latest position is observable by the
+// next frame; presses and releases are always kept, in order, together with
+// the mouse position at their time. With a 1000 Hz mouse this turns dozens of
+// moves per frame into one, while no click is lost.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Deliver the input of a frame
+// - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::InputQueue queue;
+// queue.push(sani::InputEvent(sani::InputEvent::e_MOUSE_MOVE, 0.010, p1, 0));
+// queue.push(sani::InputEvent(sani::InputEvent::e_MOUSE_MOVE, 0.011, p2, 0));
+// queue.push(sani::InputEvent(sani::InputEvent::e_MOUSE_PRESS, 0.012, p2, 1));
+// const std::vector<sani::InputEvent> batch = queue.take();
+// assert(batch.size() == 2);  // The move to 'p2' and the press
+//..
+
+#include <sani/userinput.hpp>
+
+#include <vector>
+
+namespace sani {
+
+// This class implements a queue of 'InputEvent's that coalesces mouse moves.
+class InputQueue {
+ public:
+  // Create an empty 'InputQueue' object.
+  InputQueue();
+
+  // Append the specified 'event', replacing the last queued event instead if
+  // both are mouse moves.
+  void push(const InputEvent& event);
+
+  // Return the queued events in the order they were pushed and remove them.
+  std::vector<InputEvent> take();
+
+  // Return 'true' if no events are queued, and 'false' otherwise.
+  bool empty() const;
+
+ private:
+  std::vector<InputEvent> m_events;
+};
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef SANI_INPUTREPLAY_HPP_
+#define SANI_INPUTREPLAY_HPP_
+
+//@PURPOSE: Provide deterministic replay of scripted input into animations
+//
+//@CLASSES:
+//
+//@SEE_ALSO: sani_inputtriggers, sani_interactiveanimation,
+//           sani_offscreenrenderer
+//
+//@DESCRIPTION: This component provides a function, 'replayInput', that turns
+// an 'InteractiveAnimation' into an 'Animation' by feeding it a script of
+// timestamped 'InputEvent's instead of the input of a real user, and a
+// function, 'readInputScript', that reads such a script from a text stream.
+// Pulling the resulting animation at a time first delivers the events of the
+// script up to that time, exactly as 'InteractiveAnimationView' delivers the
+// input that arrived before a frame, and then pulls the frame. Since neither a
+// window nor a clock is involved, pulling the animation at the same times
+// always yields the same frames, which makes interactive scenarios, such as
+// dragging something around or holding a key down, as reproducible as
+// passive animations. Together with 'OffscreenRenderer' this measures the
+// time spent pulling and painting the frames of such scenarios.
+//
+// A script is a text with one event per line:
+//..
+//  <time> <type> <x> <y> [<code>]
+//..
+// where '<time>' is the time of the event in seconds, '<type>' is one of
+// 'move', 'press', 'release', 'keypress', and 'keyrelease', '<x>' and '<y>'
+// are the mouse position in scene coordinates, and '<code>' is the mouse
+// button or key code, as with 'InputEvent::code', which defaults to 0. Empty
+// lines and lines starting with '#' are ignored. Times must not decrease.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Measure the frames of a drag
+// - - - - - - - - - - - - - - - - - - - -
+// Suppose the file 'drag.txt' holds the following script:
+//..
+//  # Drag from (0, 0) to (1, 1) within half a second.
+//  0.0 press 0 0 1
+//  0.1 move 0.2 0.2
+//  0.2 move 0.4 0.4
+//  0.3 move 0.6 0.6
+//  0.4 move 0.8 0.8
+//  0.5 release 1 1 1
+//..
+// We replay it into 'interactiveAnimation' at 60 frames per second and
+// collect the timing of every frame:
+//..
+// std::ifstream file("drag.txt");
+// const boost::optional<std::vector<sani::InputEvent>> opScript =
+//     sani::readInputScript(file);
+// if (opScript) {
+//   sani::OffscreenRenderer renderer(
+//       sani::replayInput(interactiveAnimation, *opScript),
+//       QSize(1920, 1080));
+//   sani::FrameStatistics statistics(16666667);
+//   for (int frame = 0; frame < 60; ++frame) {
+//     const boost::optional<sani::FrameTiming> opTiming =
+//         renderer.renderFrame(frame / 60.0);
+//     if (!opTiming)
+//       break;
+//     statistics.addFrame(*opTiming, frame ? 16666667 : 0);
+//   }
+// }
+//..
+
+#include <sani/animation.hpp>
+#include <sani/interactiveanimation.hpp>
+#include <sani/userinput.hpp>
+
+#include <boost/optional.hpp>
+#include <iosfwd>
+#include <QPointF>
+#include <vector>
+
+namespace sani {
+
+// Return an animation that feeds the specified 'script' of events into the
+// specified 'interactiveAnimation' and shows its frames. Pulling the returned
+// animation at a time delivers the events of 'script' with a time not after
+// that time that were not delivered yet, coalescing consecutive mouse moves,
+// and then pulls 'interactiveAnimation' at that time. The mouse is at the
+// optionally specified 'mousePos' until the first mouse event. The behavior
+// is undefined unless the times of 'script' do not decrease. Note that the
+// returned animation must be pulled at times that do not decrease.
+Animation replayInput(const InteractiveAnimation& interactiveAnimation,
+                      std::vector<InputEvent> script,
+                      const QPointF& mousePos = QPointF());
+
+// Read an input script in the format described above from the specified
+// 'stream'. Return the events of the script, or 'boost::none' if a line
+// cannot be parsed or the times decrease.
+boost::optional<std::vector<InputEvent>> readInputScript(std::istream& stream);
+}
+
+#endif
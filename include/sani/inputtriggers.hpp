@@ -0,0 +1,67 @@
+#ifndef SANI_INPUTTRIGGERS_HPP_
+#define SANI_INPUTTRIGGERS_HPP_
+
+//@PURPOSE: Provide the functions that feed user input into a 'UserInput'
+//
+//@CLASSES:
+//  sani::InputTriggers: triggers of the behaviors of a 'UserInput'
+//
+//@SEE_ALSO: sani_userinput, sani_inputqueue, sani_inputreplay,
+//           sani_interactiveanimationview
+//
+//@DESCRIPTION: This component provides a class, 'InputTriggers', that holds
+// the functions which trigger the behaviors of a 'UserInput', and a function,
+// 'triggerUserInput', that creates a 'UserInput' whose behaviors are
+// triggered by an 'InputTriggers' object. Anything that feeds input into an
+// 'InteractiveAnimation', be it a view reacting to a real mouse or a driver
+// replaying a script, does so by calling an 'InputTriggers' object with
+// batches of 'InputEvent's, so all of them affect an animation alike.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Click into an interactive animation
+// - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::InputTriggers triggers;
+// const sani::Animation animation =
+//     interactiveAnimation(sani::triggerUserInput(QPointF(0, 0), &triggers));
+// triggers({sani::InputEvent(sani::InputEvent::e_MOUSE_PRESS, 0.5, p, 1)});
+// const boost::optional<sani::Drawing> opFrame = animation.pull(0.5);
+//..
+
+#include <sani/userinput.hpp>
+
+#include <boost/function.hpp>
+#include <QPointF>
+#include <vector>
+
+namespace sani {
+
+// This class implements a function object that notifies an animation of a
+// batch of input events through the functions that trigger its 'UserInput'.
+// Empty functions are skipped.
+struct InputTriggers {
+  typedef void result_type;
+
+  // Update the mouse position and fire the press and release events for
+  // each of the specified 'batch' of events, in order, and then fire the
+  // batch itself.
+  void operator()(const std::vector<InputEvent>& batch) const;
+
+  boost::function<void(const QPointF&)> updateMousePos;
+  boost::function<void(const int)> notifyMousePress;
+  boost::function<void(const int)> notifyMouseRelease;
+  boost::function<void(const int)> notifyKeyPress;
+  boost::function<void(const int)> notifyKeyRelease;
+  boost::function<void(const std::vector<InputEvent>&)> notifyInputEvents;
+};
+
+// Return a 'UserInput' whose mouse position is initially the specified
+// 'mousePos' and whose behaviors are triggered by the functions stored into
+// the specified 'triggers'.
+UserInput triggerUserInput(const QPointF& mousePos, InputTriggers* triggers);
+}
+
+#endif
@@ -6,7 +6,8 @@
 //@CLASSES:
 //  sani::InteractiveAnimationView: viewer widget for InteractiveAnimations
 //
-//@SEE_ALSO: sani_interactiveanimation
+//@SEE_ALSO: sani_interactiveanimation, sani_framescheduler,
+//           sani_framestatistics, sani_recording, sani_animationhost
 //
 //@DESCRIPTION: This component provides a single class,
 // 'InteractiveAnimationView', that is a widget capable of rendering an
@@ -16,6 +17,49 @@
 // The unit of 'time' that is sent to the interactive animations is corresponds
 // to actual seconds.
 //
+// The view measures the time it spends pulling each frame from the animation
+// and painting it, as well as the interval between frames, and makes them
+// available through 'frameStatistics' and the 'frameTimed' signal. A frame is
+// reported when the next one is pulled, since it is painted in between.
+//
+// Frames are pulled whenever the view's 'FrameScheduler' ticks, by default 60
+// times per second, and only while an animation is set. An animation that only
+// changes in response to user input can be declared time-independent, in
+// which case the view stops ticking as soon as a frame is unchanged and no
+// input arrived since the previous frame, and resumes with the next input.
+//
+// In pipelined sampling mode, the animation is pulled on a separate thread
+// (see 'sani_framesampler'): on every tick the view presents the frame that
+// was pulled during the previous tick and requests the frame for the next
+// tick, so pulling and painting overlap at the cost of one tick of latency.
+// User input is then passed to the sampling thread instead of notifying the
+// animation directly. The animation must not be used by any other thread
+// meanwhile.
+//
+// User input is not delivered to the animation as it arrives. Each event is
+// stamped with the animation time at which it arrived and queued, and the
+// queue is delivered right before the next frame is pulled, with consecutive
+// mouse moves coalesced into the last one (see 'sani_inputqueue'). The
+// animation sees the batch through 'UserInput::inputEvents' and the most
+// recent state through the other 'UserInput' behaviors.
+//
+// With an OpenGL viewport, fully exposed frames are painted by a 'GlRenderer'
+// (see 'sani_glrenderer'), which batches simple primitives into vertex
+// buffers and paints the others with 'QPainter'. The viewport is multisampled
+// where supported, in place of 'QPainter' antialiasing.
+//
+// The frames the view presents can be captured with a 'RecordingWriter' (see
+// 'sani_recording'), each with the time since recording started.
+//
+// With frame optimization enabled, every frame is passed through
+// 'optimizeDrawing' (see 'sani_optimizedrawing') before it is presented, so
+// nodes that paint nothing cost neither painting nor diffing. This pays off
+// for animations that generate many such nodes; for the others it only adds
+// the cost of the optimization to the pull time of every frame. With
+// pipelined sampling, frames are optimized on the sampling thread. Hosted
+// views present the frames of their 'AnimationHost' as they are, which
+// optimizes them once for all views if so configured.
+//
 // Usage
 // -----
 // This section illustrates intended use of this component.
@@ -63,15 +107,38 @@
 // view.setInteractiveAnimation( circleFollowsMouse );
 // view.show();
 //..
+// Since only the circle moves, we could also ask the view to only repaint the
+// regions where consecutive frames differ.
+//..
+// view.setDirtyRegionUpdates(true);
+//..
+// To see whether the view keeps up with the frame rate, we can show its frame
+// statistics on top of the animation.
+//..
+// view.setFrameStatisticsOverlay(true);
+//..
+// An animation that only reacts to input, such as this one, need not be
+// pulled while the mouse is still.
+//..
+// view.setTimeIndependent(true);
+//..
 
+#include <boost/function.hpp>
+#include <boost/optional.hpp>
 #include <QGraphicsView>
+#include <sani/boundingrect.hpp>
+#include <sani/framestatistics.hpp>
 #include <sani/interactiveanimation.hpp>
+#include <sani/userinput.hpp>
 #include <memory>
-
-class QTimer;
+#include <vector>
 
 namespace sani {
 
+class AnimationHost;
+class FrameScheduler;
+class RecordingWriter;
+
 // This class implements a 2D display that views 'InteractiveAnimation's.
 class InteractiveAnimationView : public QGraphicsView {
   Q_OBJECT
@@ -82,14 +149,70 @@ class InteractiveAnimationView : public QGraphicsView {
 
   ~InteractiveAnimationView();
 
-  // Draw the current frame in the animation using the specified 'painter' and
-  // 'rect'.
+  // Draw the parts of the current frame in the animation that intersect the
+  // specified 'rect' using the specified 'painter'.
   void drawBackground(QPainter* painter, const QRectF& rect) final;
 
-  // Set the visible animation to the specified 'interactiveAnimation'.
+  // Set the visible animation to the specified 'interactiveAnimation'. This
+  // detaches the view from its animation host, if any.
   void setInteractiveAnimation(
       const InteractiveAnimation& interactiveAnimation);
 
+  // Show the frames pulled by the specified 'host' instead of running an
+  // animation of this view, and forward user input to 'host' while this view
+  // has the keyboard focus, or detach from the current host if 'host' is 0.
+  // 'host' must outlive its use by this view. The default is 0.
+  void setAnimationHost(AnimationHost* host);
+
+  // Set whether only the regions in which consecutive frames differ are
+  // repainted to the specified 'enabled'. When disabled, which is the
+  // default, the whole viewport is repainted for every frame.
+  void setDirtyRegionUpdates(bool enabled);
+
+  // Set whether frames are pulled on a separate thread, one tick ahead of
+  // their presentation, to the specified 'enabled'. The default is 'false'.
+  void setPipelinedSampling(bool enabled);
+
+  // Set whether frames are optimized with 'optimizeDrawing' before they are
+  // presented to the specified 'enabled'. The default is 'false'. This has no
+  // effect on frames of an 'AnimationHost'; see
+  // 'AnimationHost::setFrameOptimization'.
+  void setFrameOptimization(bool enabled);
+
+  // Set whether the view paints on an OpenGL viewport to the specified
+  // 'enabled'. The default is 'false', i.e. painting with the raster engine.
+  void setOpenGLViewport(bool enabled);
+
+  // Set the scheduler that decides when frames are pulled to the specified
+  // 'scheduler'. The default is a 'TimerFrameScheduler' ticking at 60 Hz.
+  void setFrameScheduler(std::unique_ptr<FrameScheduler> scheduler);
+
+  // Return the scheduler that decides when frames are pulled.
+  FrameScheduler& frameScheduler() const;
+
+  // Set whether the current and future animations only change in response
+  // to user input to the specified 'timeIndependent'. When 'true', frames
+  // are not pulled while the input is quiet and the last frame was
+  // unchanged. The default is 'false'. This has no effect while the view
+  // shows the frames of an animation host, which decides when they are
+  // pulled (see 'AnimationHost::setTimeIndependent').
+  void setTimeIndependent(bool timeIndependent);
+
+  // Return the timing statistics of the recently rendered frames.
+  const FrameStatistics& frameStatistics() const;
+
+  // Remove all frames from the frame statistics.
+  void resetFrameStatistics();
+
+  // Set whether a summary of the frame statistics is drawn over the top left
+  // corner of the view to the specified 'enabled'. The default is 'false'.
+  void setFrameStatisticsOverlay(bool enabled);
+
+  // Append every frame presented from now on to the specified 'writer', with
+  // the time since this call, or stop recording if 'writer' is 0. 'writer'
+  // must outlive its use by this view. The default is 0.
+  void setRecordingWriter(RecordingWriter* writer);
+
   // Notify the current animation that the mouse was moved using the specified
   // 'event' to discover the mouse's position.
   void mouseMoveEvent(QMouseEvent* event) final;
@@ -110,9 +233,15 @@ class InteractiveAnimationView : public QGraphicsView {
   // specified 'event' to discover which key was used.
   void keyReleaseEvent(QKeyEvent* event) final;
 
+Q_SIGNALS:
+  // This signal is emitted for every frame with the specified 'timing' of the
+  // frame and the specified 'intervalNsecs' since the previous frame started.
+  void frameTimed(const sani::FrameTiming& timing, qint64 intervalNsecs);
+
  protected:
-  // Call 'pullNewFrameFromAnimation()'.
-  void timerEvent(QTimerEvent *event) final;
+  // Draw the frame statistics overlay, if enabled, using the specified
+  // 'painter'.
+  void drawForeground(QPainter* painter, const QRectF& rect) final;
 
  private
 Q_SLOTS:
@@ -121,7 +250,49 @@ Q_SLOTS:
   // currently viewed to it.
   void pullNewFrameFromAnimation();
 
+  // Show the specified 'opDrawing', which the animation host took the
+  // specified 'pullNsecs' to pull.
+  void presentHostFrame(const boost::optional<sani::Drawing>& opDrawing,
+                        qint64 pullNsecs);
+
  private:
+  // Invalidate the specified 'changed' regions of the scene.
+  void invalidateRegions(const std::vector<DrawingBounds>& changed);
+
+  // Note that user input arrived and resume pulling frames if stopped.
+  void wake();
+
+  // Show the specified 'opDrawing', which took the specified 'pullNsecs' to
+  // pull, or stop the animation if 'opDrawing' is 'boost::none'.
+  void presentFrame(const boost::optional<Drawing>& opDrawing,
+                    qint64 pullNsecs);
+
+  // Return the time of the current animation in seconds.
+  double animationTime() const;
+
+  // Note that user input of the specified 'type' arrived with the mouse at
+  // the specified 'mousePos', in scene coordinates, and the specified 'code',
+  // and queue it for the next frame.
+  void queueInput(InputEvent::Type type, const QPointF& mousePos, int code);
+
+  // Deliver the input queued since the previous frame to the current
+  // animation.
+  void deliverInput();
+
+  // Call the specified 'input', which notifies the current animation of user
+  // input, on the thread that pulls the animation.
+  void deliver(const boost::function<void()>& input);
+
+  // Start pulling the current animation on a separate thread.
+  void startSampler();
+
+  // Add the frame that was pulled last, if any, to the frame statistics and
+  // emit 'frameTimed' for it.
+  void recordPendingFrame();
+
+  // Return the area of the viewport covered by the frame statistics overlay.
+  QRect overlayRect() const;
+
   struct Impl;
   const std::unique_ptr<Impl> m_impl;
 };
@@ -0,0 +1,64 @@
+#ifndef SANI_LAYERCACHE_HPP_
+#define SANI_LAYERCACHE_HPP_
+
+//@PURPOSE: Provide the raster image cache behind 'cachedDrawing'
+//
+//@CLASSES:
+//
+//@SEE_ALSO: sani_drawing, sani_drawinghash
+//
+//@DESCRIPTION: This component provides the function that paints 'DrawCached'
+// nodes, which are created with 'sani::cachedDrawing', and functions to
+// control the process-wide cache of rasterized layers it uses.
+//
+// The first time a 'DrawCached' node is painted at a given scale and with
+// given render hints, its child drawing is rasterized into an image, which is
+// stored under the node's structural hash, the scale, and the hints. Later
+// paints at a similar scale with the same hints, of the same or of any
+// structurally equal node, draw that image instead. Scales are rounded up to
+// quarter octaves so that images are never magnified by more than a small
+// factor and zooming does not rasterize a new image per frame.
+// Translations, and any other change of the transform that keeps the scale,
+// reuse the image.
+//
+// The cache keeps the drawing each image was rasterized from, so a node whose
+// hash merely collides with it, which is recognized with 'structurallyEqual',
+// is rasterized anew.
+//
+// Drawings whose layer would exceed 4096 pixels on a side, and drawings
+// painted with a perspective transform, are painted directly instead.
+//
+// The cache is bounded by the number of bytes of its images and evicts the
+// least recently used ones first. It is safe to paint from several threads.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Limit the memory used for cached layers
+// - - - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::setLayerCacheCapacity(16 * 1024 * 1024);
+//..
+
+#include <sani/drawing.hpp>
+
+#include <cstddef>
+
+class QPainter;
+
+namespace sani {
+
+// Paint the specified 'd' using the specified 'painter' through the layer
+// cache. The pen, brush, and font of 'painter' are left unchanged.
+void paintCached(const DrawCached& d, QPainter& painter);
+
+// Set the maximum number of bytes of images held by the layer cache to the
+// specified 'bytes', evicting images as required. The default is 64 MiB.
+void setLayerCacheCapacity(std::size_t bytes);
+
+// Remove all images from the layer cache.
+void clearLayerCache();
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef SANI_LRUCACHE_HPP_
+#define SANI_LRUCACHE_HPP_
+
+//@PURPOSE: Provide a cost-bounded cache with least-recently-used eviction
+//
+//@CLASSES:
+//  sani::LruCache: map from keys to values that evicts the least recently used
+//
+//@DESCRIPTION: This component provides a class template, 'LruCache', that maps
+// keys to values, each inserted with a caller-defined cost (e.g. a number of
+// bytes). When the total cost exceeds the maximum cost, the least recently
+// inserted or found entries are evicted until it fits again. A single entry
+// whose cost exceeds the maximum cost is never stored.
+//
+// 'LruCache' is not thread-safe; users sharing one across threads must
+// serialize access to it.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Cache images by name
+// - - - - - - - - - - - - - - - -
+//..
+// sani::LruCache<std::string, QImage> cache(64 * 1024 * 1024);
+// cache.insert("logo", logo, logo.byteCount());
+// if (const boost::optional<QImage> opLogo = cache.find("logo"))
+//   painter.drawImage(QPointF(0, 0), *opLogo);
+//..
+
+#include <boost/functional/hash.hpp>
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+namespace sani {
+
+// This class implements a cache with least-recently-used eviction.
+template <typename Key, typename Value, typename Hash = boost::hash<Key> >
+class LruCache {
+ public:
+  // Create an empty 'LruCache' object that holds entries with a total cost
+  // of at most the specified 'maxCost'.
+  explicit LruCache(std::size_t maxCost) : m_maxCost(maxCost), m_totalCost(0) {}
+
+  // Return the value stored for the specified 'key' and mark it as the most
+  // recently used entry, or return 'boost::none' if there is none.
+  boost::optional<Value> find(const Key& key) {
+    const typename Index::iterator it = m_index.find(key);
+    if (it == m_index.end())
+      return boost::none;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->value;
+  }
+
+  // Store the specified 'value' with the specified 'cost' for the specified
+  // 'key', replacing any previous value, and evict the least recently used
+  // entries until the total cost is at most the maximum cost.
+  void insert(const Key& key, const Value& value, std::size_t cost) {
+    erase(key);
+    if (cost > m_maxCost)
+      return;
+    m_entries.push_front(Entry(key, value, cost));
+    m_index[key] = m_entries.begin();
+    m_totalCost += cost;
+    trim();
+  }
+
+  // Remove the entry for the specified 'key', if any.
+  void erase(const Key& key) {
+    const typename Index::iterator it = m_index.find(key);
+    if (it == m_index.end())
+      return;
+    m_totalCost -= it->second->cost;
+    m_entries.erase(it->second);
+    m_index.erase(it);
+  }
+
+  // Remove all entries.
+  void clear() {
+    m_entries.clear();
+    m_index.clear();
+    m_totalCost = 0;
+  }
+
+  // Set the maximum total cost to the specified 'maxCost' and evict entries
+  // as required.
+  void setMaxCost(std::size_t maxCost) {
+    m_maxCost = maxCost;
+    trim();
+  }
+
+  // Return the maximum total cost.
+  std::size_t maxCost() const { return m_maxCost; }
+
+  // Return the total cost of the stored entries.
+  std::size_t totalCost() const { return m_totalCost; }
+
+  // Return the number of stored entries.
+  std::size_t size() const { return m_entries.size(); }
+
+ private:
+  struct Entry {
+    Entry(const Key& key_, const Value& value_, std::size_t cost_)
+        : key(key_), value(value_), cost(cost_) {}
+
+    Key key;
+    Value value;
+    std::size_t cost;
+  };
+  typedef std::list<Entry> Entries;  // Most recently used first
+  typedef std::unordered_map<Key, typename Entries::iterator, Hash> Index;
+
+  // Evict least recently used entries until the total cost fits.
+  void trim() {
+    while (m_totalCost > m_maxCost) {
+      m_totalCost -= m_entries.back().cost;
+      m_index.erase(m_entries.back().key);
+      m_entries.pop_back();
+    }
+  }
+
+  Entries m_entries;
+  Index m_index;
+  std::size_t m_maxCost;
+  std::size_t m_totalCost;
+};
+}
+
+#endif
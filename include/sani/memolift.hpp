@@ -0,0 +1,153 @@
+#ifndef SANI_MEMOLIFT_HPP_
+#define SANI_MEMOLIFT_HPP_
+
+//@PURPOSE: Provide lifting of drawing functions that skips unchanged inputs
+//
+//@CLASSES:
+//
+//@SEE_ALSO: sani_animation, sani_drawingdiff
+//
+//@DESCRIPTION: This component provides a function template, 'memoLift', that
+// lifts a function returning a 'Drawing' to behaviors, like 'sfrp::pmLift',
+// but remembers the arguments and the result of the last call. When the
+// behaviors are pulled and all of their values equal the remembered
+// arguments, the remembered 'Drawing' is returned without calling the
+// function, so an unchanged part of a scene costs neither the construction of
+// new nodes nor their allocation, and the nodes it shares with the previous
+// frame are recognized by identity by 'changedBounds'.
+//
+// Arguments are compared with 'memoEqual', which compares 'Drawing's with
+// 'shallowEqual', i.e. by the identity of their children rather than by
+// walking them, and all other types with 'operator=='. No comparison relies
+// on structural hashes, which may collide; in particular 'DrawCached' nodes
+// are equal only if they share their child, so a memo hit never returns a
+// frame that paints differently.
+//
+// Since a memoized 'Drawing' is returned as is, lifts of lifts stay cheap:
+// the outer lift sees the very nodes it saw before. Overloads of 'memoEqual'
+// for other types can be declared in their namespace.
+//
+// The returned animation must be pulled by one thread at a time, like any
+// animation.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Move a static drawing
+// - - - - - - - - - - - - - - - -
+// In the following animation the circle is only transformed anew in the
+// frames in which 'transformBeh' changed.
+//..
+// const sani::Animation movedDrawing = sani::memoLift(
+//     sani::transformDrawing, transformBeh, sfrp::pmConst(circle));
+//..
+
+#include <sani/animation.hpp>
+#include <sani/drawing.hpp>
+#include <sani/drawingdiff.hpp>
+
+#include <boost/optional.hpp>
+#include <sfrp/behavior.hpp>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+namespace sani {
+
+// Return 'true' if the specified 'a' and 'b' are known to be equal, and
+// 'false' otherwise.
+template <typename T>
+bool memoEqual(const T& a, const T& b) {
+  return a == b;
+}
+
+// Return 'shallowEqual(a, b)' for the specified 'a' and 'b'.
+inline bool memoEqual(const Drawing& a, const Drawing& b) {
+  return shallowEqual(a, b);
+}
+
+// A list of tuple indices
+template <std::size_t... Indices>
+struct MemoLift_Indices {};
+
+// The 'MemoLift_Indices' from 0 to 'N - 1' followed by 'Indices'
+template <std::size_t N, std::size_t... Indices>
+struct MemoLift_MakeIndices
+    : MemoLift_MakeIndices<N - 1, N - 1, Indices...> {};
+
+template <std::size_t... Indices>
+struct MemoLift_MakeIndices<0, Indices...> {
+  typedef MemoLift_Indices<Indices...> type;
+};
+
+// This class implements the pull function of an animation created by
+// 'memoLift'. Copies share the remembered call.
+template <typename Function, typename... Args>
+class MemoLift_Pull {
+ public:
+  MemoLift_Pull(Function function, const sfrp::Behavior<Args>&... behaviors)
+      : m_function(std::move(function)),
+        m_behaviors(behaviors...),
+        m_memo(std::make_shared<Memo>()) {}
+
+  boost::optional<Drawing> operator()(double time) const {
+    return pull(time,
+                typename MemoLift_MakeIndices<sizeof...(Args)>::type());
+  }
+
+ private:
+  // The arguments and the result of the last call of the function
+  struct Memo {
+    boost::optional<std::tuple<Args...>> opArguments;
+    Drawing result;
+  };
+
+  template <std::size_t... Indices>
+  boost::optional<Drawing> pull(double time,
+                                MemoLift_Indices<Indices...>) const {
+    const std::tuple<boost::optional<Args>...> values(
+        std::get<Indices>(m_behaviors).pull(time)...);
+    if (!all({bool(std::get<Indices>(values))...}))
+      return boost::none;
+
+    Memo& memo = *m_memo;
+    if (!memo.opArguments ||
+        !all({memoEqual(std::get<Indices>(*memo.opArguments),
+                        *std::get<Indices>(values))...})) {
+      memo.opArguments = std::tuple<Args...>(*std::get<Indices>(values)...);
+      memo.result = m_function(std::get<Indices>(*memo.opArguments)...);
+    }
+    return memo.result;
+  }
+
+  // Return 'true' if all of the specified 'conditions' hold, and 'false'
+  // otherwise.
+  static bool all(std::initializer_list<bool> conditions) {
+    for (const bool condition : conditions)
+      if (!condition)
+        return false;
+    return true;
+  }
+
+  Function m_function;
+  std::tuple<sfrp::Behavior<Args>...> m_behaviors;
+  std::shared_ptr<Memo> m_memo;
+};
+
+// Return an animation whose frame at any time is the specified 'function'
+// applied to the values of the specified 'behaviors' at that time, or
+// 'boost::none' if any of them has no value. 'function' is only called when
+// the values differ, according to 'memoEqual', from those it was last called
+// with; otherwise the frame it returned then is returned again.
+template <typename Function, typename... Args>
+Animation memoLift(Function function,
+                   const sfrp::Behavior<Args>&... behaviors) {
+  return Animation::fromValuePullFunc(
+      MemoLift_Pull<Function, Args...>(std::move(function), behaviors...));
+}
+}
+
+#endif
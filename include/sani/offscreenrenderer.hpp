@@ -0,0 +1,92 @@
+#ifndef SANI_OFFSCREENRENDERER_HPP_
+#define SANI_OFFSCREENRENDERER_HPP_
+
+//@PURPOSE: Provide a renderer of 'Animation's into images without a window
+//
+//@CLASSES:
+//  sani::OffscreenRenderer: renders frames of an 'Animation' into a 'QImage'
+//
+//@SEE_ALSO: sani_animation, sani_framestatistics,
+//           sani_interactiveanimationview
+//
+//@DESCRIPTION: This component provides a class, 'OffscreenRenderer', that
+// pulls an 'Animation' at times chosen by the caller and paints each frame
+// into a 'QImage' of a fixed size. It needs neither a window nor an event
+// loop, so it works with the 'offscreen' Qt platform plugin, e.g. to measure
+// the rendering performance of scenes on a headless server.
+//
+// Frames are painted the way 'InteractiveAnimationView' paints a fully
+// exposed frame. The time spent pulling each frame from the animation and the
+// time spent painting it are measured separately and reported as a
+// 'FrameTiming'.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Measure the paint time of ten seconds of an animation
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::OffscreenRenderer renderer(animation, QSize(1920, 1080));
+// renderer.setTransform(QTransform::fromScale(100.0, 100.0));
+// qint64 paintNsecs = 0;
+// for (int frame = 0; frame < 600; ++frame) {
+//   const boost::optional<sani::FrameTiming> opTiming =
+//       renderer.renderFrame(frame / 60.0);
+//   if (!opTiming)
+//     break;
+//   paintNsecs += opTiming->paintNsecs;
+// }
+//..
+
+#include <sani/animation.hpp>
+#include <sani/framestatistics.hpp>
+
+#include <boost/optional.hpp>
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QTransform>
+
+class QSize;
+
+namespace sani {
+
+// This class implements a renderer of 'Animation' frames into a 'QImage'.
+class OffscreenRenderer {
+ public:
+  // Create an 'OffscreenRenderer' object that renders the specified
+  // 'animation' into images of the specified 'size'. Drawing coordinates are
+  // image pixels until 'setTransform' is called.
+  OffscreenRenderer(const Animation& animation, const QSize& size);
+
+  // Set the transform from drawing coordinates to image pixels to the
+  // specified 't'.
+  void setTransform(const QTransform& t);
+
+  // Set the color the image is filled with before each frame is painted to
+  // the specified 'color'. The default is white.
+  void setBackground(const QColor& color);
+
+  // Set the render hints used to paint frames to the specified 'hints'. The
+  // default is 'QPainter::Antialiasing'.
+  void setRenderHints(QPainter::RenderHints hints);
+
+  // Pull the frame of the animation at the specified 'time', in seconds, and
+  // paint it into the image. Return the time spent doing so, or 'boost::none'
+  // if the animation has ended, in which case the image is left unchanged.
+  boost::optional<FrameTiming> renderFrame(double time);
+
+  // Return the image holding the last rendered frame.
+  const QImage& image() const;
+
+ private:
+  Animation m_animation;
+  QImage m_image;
+  QTransform m_transform;
+  QColor m_background;
+  QPainter::RenderHints m_renderHints;
+};
+}
+
+#endif
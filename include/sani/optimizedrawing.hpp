@@ -0,0 +1,56 @@
+#ifndef SANI_OPTIMIZEDRAWING_HPP_
+#define SANI_OPTIMIZEDRAWING_HPP_
+
+//@PURPOSE: Provide a rewrite of 'Drawing's that removes nodes painting nothing
+//
+//@CLASSES:
+//
+//@SEE_ALSO: sani_drawing, sani_flattendrawing, sani_rewritedrawing
+//
+//@DESCRIPTION: This component provides a function, 'optimizeDrawing', that
+// returns a 'Drawing' that paints like a given one but has fewer nodes. Code
+// that generates scenes tends to produce nodes that do nothing, each of which
+// costs an allocation when built and a visit whenever the drawing is painted,
+// bounded, or diffed. The following rewrites are applied, bottom up:
+//
+//: o 'DrawNothing' operands of 'DrawOver' and children of 'DrawGroup' are
+//:   removed; a 'DrawGroup' left with one child is replaced by it.
+//:
+//: o Identity 'DrawTransform's are removed, and a 'DrawTransform' directly
+//:   enclosing another one is merged with it into one matrix.
+//:
+//: o Primitives that paint nothing are replaced by 'DrawNothing': those whose
+//:   pen is 'Qt::NoPen' or fully transparent and whose brush, if they have
+//:   one, is 'Qt::NoBrush', fully transparent, or fills a rectangle without
+//:   area, as well as texts without characters.
+//:
+//: o Composite nodes all of whose children paint nothing, and 'DrawInstances'
+//:   nodes without instances, are replaced by 'DrawNothing'.
+//
+// Since the colors of the pens and brushes of the template of a
+// 'DrawInstances' node with colors are replaced when painted, transparent
+// pens and brushes are kept in such templates. The children of 'DrawCached'
+// nodes are left as they are since they are painted from a cached image
+// anyway. The result shares the subtrees that need no rewrite with the
+// original drawing, as described in 'sani_rewritedrawing'.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Optimize a generated scene
+// - - - - - - - - - - - - - - - - - - -
+//..
+// const sani::Drawing scene = sani::optimizeDrawing(layOut(document));
+//..
+
+#include <sani/drawing.hpp>
+
+namespace sani {
+
+// Return a drawing that paints like the specified 'd' without the nodes that
+// paint nothing, identity transforms, and directly nested transforms.
+Drawing optimizeDrawing(const Drawing& d);
+}
+
+#endif
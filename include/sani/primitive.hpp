@@ -0,0 +1,91 @@
+#ifndef SANI_PRIMITIVE_HPP_
+#define SANI_PRIMITIVE_HPP_
+
+//@PURPOSE: Provide a variant over the leaf drawing types and their painting
+//
+//@CLASSES:
+//  sani::Primitive: a single, non-composite drawing command
+//
+//@SEE_ALSO: sani_drawing, sani_displaylist, sani_painterstatecache
+//
+//@DESCRIPTION: This component provides a type, 'Primitive', that can hold any
+// of the 'Drawing' alternatives that directly paint something (as opposed to
+// 'DrawOver', 'DrawGroup', 'DrawTransform', 'DrawInstances', 'DrawLOD', and
+// 'DrawNothing' which only combine other drawings). A set of 'paintPrimitive'
+// overloads paints a single primitive with a 'QPainter' using the pen, brush,
+// and font stored in the primitive. The overload taking a 'PainterStateCache'
+// only changes the painter's style when it differs from that of the
+// previously painted primitive. 'recolor' replaces the colours of a
+// primitive's pen and brush.
+//
+// 'DrawCached' counts as a primitive: it is painted as a single image from the
+// layer cache (see 'sani_layercache') and never changes the painter's style.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Paint a single primitive
+// - - - - - - - - - - - - - - - - - -
+//..
+// const sani::Primitive p =
+//     sani::DrawLine(QPen(Qt::black), QPointF(0, 0), QPointF(1, 1));
+// sani::paintPrimitive(p, painter);
+//..
+
+#include <sani/drawing.hpp>
+
+#include <boost/variant.hpp>
+
+class QColor;
+class QPainter;
+
+namespace sani {
+
+class PainterStateCache;
+
+typedef boost::variant<DrawPoint,
+                       DrawLine,
+                       DrawRect,
+                       DrawRoundedRect,
+                       DrawText,
+                       DrawEllipse,
+                       DrawArc,
+                       DrawPie,
+                       DrawChord,
+                       DrawCached> Primitive;
+
+// Paint the specified primitive 'd' using the specified 'painter'. The pen,
+// brush, and font of 'painter' are set to those of 'd' as required.
+void paintPrimitive(const DrawPoint& d, QPainter& painter);
+void paintPrimitive(const DrawLine& d, QPainter& painter);
+void paintPrimitive(const DrawRect& d, QPainter& painter);
+void paintPrimitive(const DrawRoundedRect& d, QPainter& painter);
+void paintPrimitive(const DrawText& d, QPainter& painter);
+void paintPrimitive(const DrawEllipse& d, QPainter& painter);
+void paintPrimitive(const DrawArc& d, QPainter& painter);
+void paintPrimitive(const DrawPie& d, QPainter& painter);
+void paintPrimitive(const DrawChord& d, QPainter& painter);
+void paintPrimitive(const DrawCached& d, QPainter& painter);
+void paintPrimitive(const Primitive& p, QPainter& painter);
+
+// Paint the specified primitive 'p' using the painter of the specified
+// 'state', changing its pen, brush, and font through 'state'.
+void paintPrimitive(const DrawPoint& d, PainterStateCache& state);
+void paintPrimitive(const DrawLine& d, PainterStateCache& state);
+void paintPrimitive(const DrawRect& d, PainterStateCache& state);
+void paintPrimitive(const DrawRoundedRect& d, PainterStateCache& state);
+void paintPrimitive(const DrawText& d, PainterStateCache& state);
+void paintPrimitive(const DrawEllipse& d, PainterStateCache& state);
+void paintPrimitive(const DrawArc& d, PainterStateCache& state);
+void paintPrimitive(const DrawPie& d, PainterStateCache& state);
+void paintPrimitive(const DrawChord& d, PainterStateCache& state);
+void paintPrimitive(const DrawCached& d, PainterStateCache& state);
+void paintPrimitive(const Primitive& p, PainterStateCache& state);
+
+// Set the colour of the pen and, if it has one, the brush of the specified
+// primitive 'p' to the specified 'color'. A 'DrawCached' is left unchanged.
+void recolor(Primitive& p, const QColor& color);
+}
+
+#endif
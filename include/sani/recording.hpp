@@ -0,0 +1,162 @@
+#ifndef SANI_RECORDING_HPP_
+#define SANI_RECORDING_HPP_
+
+//@PURPOSE: Provide compact binary recordings of animation frames and replay
+//
+//@CLASSES:
+//  sani::RecordingWriter: appends timed 'Drawing' frames to a recording
+//  sani::RecordingReader: reads frames from a memory-mapped recording
+//
+//@SEE_ALSO: sani_animation, sani_interactiveanimationview,
+//           sani_offscreenrenderer
+//
+//@DESCRIPTION: This component provides a class, 'RecordingWriter', that
+// serializes a sequence of timed 'Drawing' frames into a compact binary
+// recording, a class, 'RecordingReader', that reads the frames back from a
+// memory-mapped recording file, and a function, 'replayAnimation', that turns
+// a recording into an 'Animation'. A replayed animation can be viewed in an
+// 'InteractiveAnimationView' or rendered with an 'OffscreenRenderer' without
+// running the code that originally produced the frames, e.g. to investigate a
+// captured session or to reproduce its rendering performance.
+//
+// Pens, brushes, fonts, and strings are interned: each distinct value is
+// stored once and referred to by index afterwards. Drawings are stored as
+// graphs of nodes, and a node that is shared between frames, which is typical
+// of animations that wrap unchanged drawings in new composite nodes, is
+// stored once and referred to by later frames. Sharing is recognized by node
+// identity, so it costs no comparison.
+//
+// Every few frames, 300 by default, the writer emits a keyframe, which
+// refers to nothing stored before it. Reading a frame starts at the keyframe
+// preceding it, so seeking costs at most one keyframe interval of decoding,
+// and playing frames in order decodes each frame once. The writer keeps the
+// nodes stored since the last keyframe alive, so the keyframe interval also
+// bounds its memory use.
+//
+// A recording ends with an index of its frames, written by
+// 'RecordingWriter::finish'; a recording that was not finished cannot be
+// read. The format is independent of the platform's byte order.
+//
+// Neither class is thread-safe.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Record the frames shown by a view
+// - - - - - - - - - - - - - - - - - - - - - -
+//..
+// QFile file("session.sanirec");
+// file.open(QIODevice::WriteOnly);
+// sani::RecordingWriter writer(file);
+// view.setRecordingWriter(&writer);
+//
+// // ... when the session ends
+// view.setRecordingWriter(0);
+// writer.finish();
+//..
+//
+// Example 2: Replay a recording
+// - - - - - - - - - - - - - - -
+//..
+// const std::shared_ptr<sani::RecordingReader> reader =
+//     std::make_shared<sani::RecordingReader>();
+// if (reader->open("session.sanirec")) {
+//   const sani::Animation replay = sani::replayAnimation(reader);
+//   view.setInteractiveAnimation(
+//       [replay](const sani::UserInput&) { return replay; });
+// }
+//..
+
+#include <sani/animation.hpp>
+
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <memory>
+
+class QIODevice;
+class QString;
+
+namespace sani {
+
+// This class implements a writer of frames into a binary recording.
+class RecordingWriter {
+ public:
+  // Create a 'RecordingWriter' object that writes a recording to the
+  // specified 'device', starting at its current position. 'device' must be
+  // open for writing and outlive this object.
+  explicit RecordingWriter(QIODevice& device);
+
+  ~RecordingWriter();
+
+  // Set the number of frames after which a keyframe is written to the
+  // specified 'frames'. The behavior is undefined unless '0 < frames'.
+  void setKeyframeInterval(int frames);
+
+  // Append the specified 'frame' shown at the specified 'time', in seconds.
+  // The behavior is undefined unless 'time' is not less than the time of the
+  // previous frame and 'finish' was not called.
+  void addFrame(double time, const Drawing& frame);
+
+  // Write the index of the frames, which completes the recording. Return
+  // 'true' if all data was written, and 'false' otherwise.
+  bool finish();
+
+ private:
+  RecordingWriter(const RecordingWriter&);
+  RecordingWriter& operator=(const RecordingWriter&);
+
+  struct Impl;
+  const std::unique_ptr<Impl> m_impl;
+};
+
+// This class implements a reader of frames from a binary recording file.
+class RecordingReader {
+ public:
+  // Create a 'RecordingReader' object with no recording open.
+  RecordingReader();
+
+  ~RecordingReader();
+
+  // Memory-map the recording at the end of the file with the specified
+  // 'fileName', closing the one open before, if any. The recording may be
+  // preceded by other data. Return 'true' on success, and 'false' if the
+  // file cannot be mapped or does not end with a finished recording.
+  bool open(const QString& fileName);
+
+  // Unmap the open recording, if any.
+  void close();
+
+  // Return the number of frames in the open recording.
+  std::size_t frameCount() const;
+
+  // Return the time, in seconds, of the frame with the specified 'index'.
+  // The behavior is undefined unless 'index < frameCount()'.
+  double frameTime(std::size_t index) const;
+
+  // Return the frame with the specified 'index', or 'boost::none' if the
+  // recording is corrupt. The behavior is undefined unless
+  // 'index < frameCount()'.
+  boost::optional<Drawing> frame(std::size_t index);
+
+  // Return the frame that is shown at the specified 'time', in seconds,
+  // i.e. the last frame whose time is not after 'time', or the first frame
+  // if there is none. Return 'boost::none' if the recording has no frames or
+  // is corrupt.
+  boost::optional<Drawing> frameAt(double time);
+
+ private:
+  RecordingReader(const RecordingReader&);
+  RecordingReader& operator=(const RecordingReader&);
+
+  struct Impl;
+  const std::unique_ptr<Impl> m_impl;
+};
+
+// Return an animation whose frame at any time is the frame of the specified
+// 'reader' shown at that time. The animation shows the last frame of the
+// recording indefinitely and uses 'reader' whenever it is pulled.
+Animation replayAnimation(const std::shared_ptr<RecordingReader>& reader);
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef SANI_REWRITEDRAWING_HPP_
+#define SANI_REWRITEDRAWING_HPP_
+
+//@PURPOSE: Provide an iterative bottom-up rewrite of 'Drawing's
+//
+//@CLASSES:
+//  sani::DrawingRewriter: protocol for the rules of a bottom-up rewrite
+//
+//@SEE_ALSO: sani_flattendrawing, sani_optimizedrawing
+//
+//@DESCRIPTION: This component provides a protocol class, 'DrawingRewriter',
+// that describes a rewrite of a 'Drawing' as two rules, and a function,
+// 'rewriteDrawing', that applies them bottom up. 'appendOperands' lists the
+// nodes whose rewritten forms make up the rewritten form of a node, and
+// 'rebuild' combines them. Nodes without operands are leaves of the rewrite
+// and are passed to 'rebuild' directly.
+//
+// Each operand carries an integer context, such as whether the colours of the
+// operand are replaced when painted, that the rules may use to rewrite the
+// same node differently depending on where it occurs. The root is rewritten in
+// context 0.
+//
+// 'rewriteDrawing' keeps its own stack, so drawings of any depth are rewritten
+// without exhausting the call stack. Subtrees that 'rebuild' leaves as they
+// are stay shared with the original drawing rather than copied, and a
+// composite node that is shared within the original drawing is rewritten only
+// once per context and stays shared in the result.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Remove the transforms of a drawing
+// - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// class TransformRemover : public sani::DrawingRewriter {
+//  public:
+//   void appendOperands(const sani::DrawingNode& node, int context,
+//                       std::vector<Operand>& operands) override {
+//     if (const sani::DrawTransform* const transform =
+//             boost::get<sani::DrawTransform>(node.get()))
+//       operands.push_back(Operand(transform->d, context));
+//   }
+//
+//   sani::DrawingNode rebuild(const sani::DrawingNode& node, int,
+//                             const sani::DrawingNode* operands,
+//                             std::size_t count) override {
+//     return count == 0 ? node : operands[0];
+//   }
+// };
+//
+// TransformRemover remover;
+// const sani::Drawing untransformed = sani::rewriteDrawing(scene, remover);
+//..
+
+#include <sani/drawing.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace sani {
+
+// A shared node of a drawing that is being rewritten
+typedef std::shared_ptr<const Drawing> DrawingNode;
+
+// This protocol class describes the rules of a bottom-up rewrite of a drawing.
+class DrawingRewriter {
+ public:
+  // A node to rewrite in a context
+  struct Operand {
+    Operand(const DrawingNode& node_, int context_)
+        : node(node_), context(context_) {}
+
+    DrawingNode node;
+    int context;
+  };
+
+  virtual ~DrawingRewriter();
+
+  // Append the operands of the specified 'node' in the specified 'context' to
+  // the specified 'operands' in order, or nothing if 'node' is a leaf of the
+  // rewrite.
+  virtual void appendOperands(const DrawingNode& node, int context,
+                              std::vector<Operand>& operands) = 0;
+
+  // Return the rewritten form of the specified 'node' in the specified
+  // 'context' given the rewritten forms of the specified 'count' operands of
+  // 'node' starting at the specified 'operands'. Return 'node' itself to keep
+  // it unchanged.
+  virtual DrawingNode rebuild(const DrawingNode& node, int context,
+                              const DrawingNode* operands,
+                              std::size_t count) = 0;
+};
+
+// Return the specified 'd' rewritten bottom up by the specified 'rewriter'.
+Drawing rewriteDrawing(const Drawing& d, DrawingRewriter& rewriter);
+
+// Return 'true' if the specified 'count' nodes starting at the specified
+// 'nodes' are the elements of the specified 'drawings' in order, and 'false'
+// otherwise.
+bool sameDrawings(const std::vector<Drawing>& drawings,
+                  const DrawingNode* nodes, std::size_t count);
+
+// Return copies of the drawings of the specified 'count' nodes starting at
+// the specified 'nodes'.
+std::vector<Drawing> copyDrawings(const DrawingNode* nodes, std::size_t count);
+}
+
+#endif
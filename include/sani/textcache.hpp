@@ -0,0 +1,55 @@
+#ifndef SANI_TEXTCACHE_HPP_
+#define SANI_TEXTCACHE_HPP_
+
+//@PURPOSE: Provide a cache of laid out text for painting 'DrawText'
+//
+//@CLASSES:
+//
+//@SEE_ALSO: sani_primitive, sani_lrucache
+//
+//@DESCRIPTION: This component provides the function that paints the text of
+// 'DrawText' primitives, and a function to bound the memory it uses.
+//
+// Converting a label to a 'QString' and shaping it is usually the most
+// expensive part of painting it. 'paintText' keeps the converted and laid out
+// text of recently painted labels, keyed by their text and font, as
+// 'QStaticText' objects, so labels that are painted on every frame are only
+// shaped once. The least recently used labels are evicted when the cached
+// text exceeds the capacity, which is measured in bytes of UTF-8 text plus a
+// small fixed amount per label.
+//
+// Since painting a 'QStaticText' may update its layout, each thread that
+// paints text has its own cache. The capacity applies to each of them.
+//
+// Text containing line breaks is painted without the cache, since
+// 'QStaticText' would lay it out on several lines where 'QPainter::drawText'
+// does not.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Allow more labels to be cached
+// - - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::setTextCacheCapacity(4 * 1024 * 1024);
+//..
+
+#include <sani/drawing.hpp>
+
+#include <cstddef>
+
+class QPainter;
+
+namespace sani {
+
+// Draw the text of the specified 'd' at its position using the specified
+// 'painter', whose pen and font must already be those of 'd'.
+void paintText(const DrawText& d, QPainter& painter);
+
+// Set the maximum number of bytes of text held by the text cache of each
+// thread to the specified 'bytes'. The default is 1 MiB.
+void setTextCacheCapacity(std::size_t bytes);
+}
+
+#endif
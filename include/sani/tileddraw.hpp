@@ -0,0 +1,59 @@
+#ifndef SANI_TILEDDRAW_HPP_
+#define SANI_TILEDDRAW_HPP_
+
+//@PURPOSE: Provide parallel drawing of a 'Drawing' into a 'QImage'
+//
+//@CLASSES:
+//
+//@SEE_ALSO: sani_drawing, sani_boundingrect
+//
+//@DESCRIPTION: This component provides a function, 'drawTiled', that draws a
+// 'Drawing' into a 'QImage' on several threads. The image is split into
+// square tiles that are drawn by the threads of the global 'QThreadPool' and
+// by the calling thread. Each tile gets its own 'QPainter' on a 'QImage' that
+// shares the memory of its part of the target, so the tiles need no
+// compositing afterwards, and each tile skips the subtrees whose bounds do
+// not intersect it (see the culling 'draw' overload).
+//
+// Since every pixel is rasterized by exactly one painter with the same
+// transform as in a single painter covering the whole image, the result
+// matches that of 'draw' up to the rounding of antialiased edges, except that
+// the clipping of each painter to its tile cannot be observed.
+//
+// Only images with 32 bits per pixel are split into tiles; other images are
+// drawn on the calling thread.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Render a frame at 4K
+// - - - - - - - - - - - - - - - -
+//..
+// QImage image(3840, 2160, QImage::Format_ARGB32_Premultiplied);
+// image.fill(Qt::white);
+// sani::drawTiled(frame, image, QTransform::fromScale(100.0, 100.0));
+//..
+
+#include <sani/drawing.hpp>
+
+#include <QPainter>
+#include <QTransform>
+
+class QImage;
+
+namespace sani {
+
+// Draw the specified 'd', mapped to pixels with the specified 'toImage'
+// transform, into the specified 'image' with the specified 'hints', on tiles
+// of the specified 'tileSize' pixels drawn in parallel. The behavior is
+// undefined unless 'tileSize' is positive and 'image' is not painted on or
+// otherwise used by other threads during the call.
+void drawTiled(const Drawing& d,
+               QImage& image,
+               const QTransform& toImage = QTransform(),
+               QPainter::RenderHints hints = QPainter::Antialiasing,
+               int tileSize = 256);
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef SANI_TRIPLEBUFFER_HPP_
+#define SANI_TRIPLEBUFFER_HPP_
+
+//@PURPOSE: Provide a lock-free hand-off of values between two threads
+//
+//@CLASSES:
+//  sani::TripleBuffer: single-producer, single-consumer latest-value buffer
+//
+//@SEE_ALSO: sani_framesampler
+//
+//@DESCRIPTION: This component provides a class template, 'TripleBuffer', that
+// passes the most recent of a stream of values from one producer thread to
+// one consumer thread without locks and without either thread ever waiting
+// for the other. The producer fills the 'back' slot and 'publish'es it; the
+// consumer calls 'update' to make the most recently published value its
+// 'front' slot. Values that are published but never picked up by 'update'
+// before a newer one is published are silently dropped, which is the desired
+// behavior for frames of an animation.
+//
+// The three slots are swapped by index through a single atomic word, so the
+// values themselves are never copied by the buffer.
+//
+// Usage
+// -----
+// This section illustrates intended use of this component.
+//
+// Example 1: Pass the latest frame from a worker to the GUI thread
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//..
+// sani::TripleBuffer<sani::Drawing> frames;
+//
+// // Worker thread
+// frames.back() = pullNextFrame();
+// frames.publish();
+//
+// // GUI thread
+// if (frames.update())
+//   show(frames.front());
+//..
+
+#include <atomic>
+
+namespace sani {
+
+// This class implements a lock-free buffer of the latest of a stream of
+// values, written by one thread and read by another.
+template <typename T>
+class TripleBuffer {
+ public:
+  // Create a 'TripleBuffer' object with three default constructed slots and
+  // no published value.
+  TripleBuffer() : m_middle(1), m_back(2), m_front(0) {}
+
+  // Return the slot the producer fills before calling 'publish'. Must only be
+  // called by the producer.
+  T& back() { return m_slots[m_back]; }
+
+  // Make the 'back' slot the most recently published value and give the
+  // producer a new 'back' slot. Must only be called by the producer.
+  void publish() {
+    m_back = m_middle.exchange(m_back | freshBit, std::memory_order_acq_rel) &
+             indexMask;
+  }
+
+  // Make the most recently published value the 'front' slot, if a value was
+  // published since the last call, and return 'true'; otherwise return
+  // 'false'. Must only be called by the consumer.
+  bool update() {
+    if (!(m_middle.load(std::memory_order_acquire) & freshBit))
+      return false;
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & indexMask;
+    return true;
+  }
+
+  // Return the slot holding the value the consumer last obtained through
+  // 'update'. Must only be called by the consumer.
+  T& front() { return m_slots[m_front]; }
+
+ private:
+  TripleBuffer(const TripleBuffer&);
+  TripleBuffer& operator=(const TripleBuffer&);
+
+  static const unsigned indexMask = 3;
+  static const unsigned freshBit = 4;  // Set when 'm_middle' is unread
+
+  T m_slots[3];
+  std::atomic<unsigned> m_middle;  // Index of the hand-off slot | 'freshBit'
+  unsigned m_back;                 // Owned by the producer
+  unsigned m_front;                // Owned by the consumer
+};
+}
+
+#endif
@@ -2,10 +2,20 @@
 //
 //@CLASSES:
 //  sani::UserInput: A collection of behaviors for user input
+//  sani::InputEvent: A single, timestamped user input event
 //
 //@DESCRIPTION: This component provides a struct that collects common user input
 // behaviors for use in frp applications.
 //
+// Besides the behaviors that hold the latest mouse position and the latest
+// presses and releases, 'UserInput' provides 'inputEvents', which holds the
+// batch of 'InputEvent's delivered with a frame. Each event carries the time
+// at which it actually happened, in the time frame of the animation, so a
+// behavior can, e.g., hit-test a click against the scene as it was at the
+// time of the click rather than at the time the frame is pulled. Consecutive
+// mouse moves within a batch are coalesced into the last one, while every
+// press and release is kept.
+//
 // Usage
 // -----
 // This section illustrates intended use of this component.
@@ -36,12 +46,45 @@
 #define SANI_USERINPUT_HPP_
 
 #include <boost/optional.hpp>
+#include <QPointF>
 #include <sfrp/behavior.hpp>
-
-class QPointF;
+#include <vector>
 
 namespace sani {
 
+// This class implements a value-semantic description of a single user input
+// event.
+struct InputEvent {
+  // The kinds of input events
+  enum Type {
+    e_MOUSE_MOVE,
+    e_MOUSE_PRESS,
+    e_MOUSE_RELEASE,
+    e_KEY_PRESS,
+    e_KEY_RELEASE
+  };
+
+  // Create an 'InputEvent' object describing a mouse move to the origin at
+  // time 0.
+  InputEvent() : type(e_MOUSE_MOVE), time(0.0), code(0) {}
+
+  // Create an 'InputEvent' object with the specified 'type', 'time',
+  // 'mousePos', and 'code'.
+  InputEvent(Type type_, double time_, const QPointF& mousePos_, int code_)
+      : type(type_), time(time_), mousePos(mousePos_), code(code_) {}
+
+  Type type;
+
+  double time;  // Time of the event, in seconds, in the time frame of the
+                // animation
+
+  QPointF mousePos;  // Position of the mouse at the time of the event
+
+  int code;  // The button of a mouse press or release, as with
+             // 'UserInput::mousePress', the key code of a key press or
+             // release, and 0 for a mouse move.
+};
+
 // This class implements a collection of behaviors that represent common user
 // input behaviors.
 struct UserInput {
@@ -57,6 +100,16 @@ struct UserInput {
             sfrp::Behavior<boost::optional<int>> keyPress,
             sfrp::Behavior<boost::optional<int>> keyRelease);
 
+  // Create a 'UserInput' object with the specified 'mousePos', 'mousePress',
+  // 'mouseRelease', 'keyPress', 'keyRelease', and 'inputEvents' behaviors.
+  UserInput(
+      sfrp::Behavior<QPointF> mousePos,
+      sfrp::Behavior<boost::optional<int>> mousePress,
+      sfrp::Behavior<boost::optional<int>> mouseRelease,
+      sfrp::Behavior<boost::optional<int>> keyPress,
+      sfrp::Behavior<boost::optional<int>> keyRelease,
+      sfrp::Behavior<boost::optional<std::vector<InputEvent>>> inputEvents);
+
   sfrp::Behavior<QPointF> mousePos;  // The position of a mouse
 
   sfrp::Behavior<boost::optional<int>> mousePress;  // Instances of when the
@@ -79,6 +132,10 @@ struct UserInput {
                                                     // released. The 'int'
                                                     // corresponds to the key
                                                     // code.
+
+  sfrp::Behavior<boost::optional<std::vector<InputEvent>>>
+      inputEvents;  // Instances of when a batch of input events is delivered,
+                    // in the order they happened.
 };
 }
 #endif
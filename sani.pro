@@ -9,10 +9,36 @@ addStaticLibDependency($$SBASE_PATH,sbase)
 ## Sources
 
 SOURCES += src/sani_animation.cpp
+HEADERS += include/sani/animationhost.hpp
+SOURCES += src/sani_animationhost.cpp
+SOURCES += src/sani_boundingrect.cpp
+SOURCES += src/sani_displaylist.cpp
 SOURCES += src/sani_drawing.cpp
+SOURCES += src/sani_drawingdiff.cpp
+SOURCES += src/sani_drawinghash.cpp
+SOURCES += src/sani_flattendrawing.cpp
+SOURCES += src/sani_frameexport.cpp
+SOURCES += src/sani_framesampler.cpp
+HEADERS += include/sani/framescheduler.hpp
+SOURCES += src/sani_framescheduler.cpp
+SOURCES += src/sani_framestatistics.cpp
+SOURCES += src/sani_glrenderer.cpp
+SOURCES += src/sani_idlehelpers.cpp
+SOURCES += src/sani_inputqueue.cpp
+SOURCES += src/sani_inputreplay.cpp
+SOURCES += src/sani_inputtriggers.cpp
 SOURCES += src/sani_interactiveanimation.cpp
 HEADERS += include/sani/interactiveanimationview.hpp
 SOURCES += src/sani_interactiveanimationview.cpp
+SOURCES += src/sani_layercache.cpp
+SOURCES += src/sani_offscreenrenderer.cpp
+SOURCES += src/sani_optimizedrawing.cpp
+SOURCES += src/sani_painterstatecache.cpp
+SOURCES += src/sani_primitive.cpp
+SOURCES += src/sani_recording.cpp
+SOURCES += src/sani_rewritedrawing.cpp
+SOURCES += src/sani_textcache.cpp
+SOURCES += src/sani_tileddraw.cpp
 SOURCES += src/sani_userinput.cpp
 
 ## Build Options
@@ -0,0 +1,124 @@
+#include <sani/animationhost.hpp>
+
+#include <sani/animation.hpp>
+#include <sani/drawingdiff.hpp>
+#include <sani/framescheduler.hpp>
+#include <sani/inputqueue.hpp>
+#include <sani/inputtriggers.hpp>
+#include <sani/optimizedrawing.hpp>
+
+#include <QElapsedTimer>
+
+namespace sani {
+
+struct AnimationHost::Impl {
+  Impl()
+      : m_scheduler(new TimerFrameScheduler()),
+        m_timeIndependent(false),
+        m_optimizeFrames(false),
+        m_inputSinceLastFrame(false) {}
+
+  QElapsedTimer m_startTime;
+  boost::optional<Animation> m_opAnimation;
+  InputTriggers m_triggers;  // Triggers of the animation's 'UserInput'
+  InputQueue m_inputQueue;   // Input since the last frame
+  std::unique_ptr<FrameScheduler> m_scheduler;
+  bool m_timeIndependent;
+  bool m_optimizeFrames;
+  bool m_inputSinceLastFrame;
+  boost::optional<Drawing> m_opLastFrame;  // Kept if 'm_timeIndependent'
+};
+
+AnimationHost::AnimationHost() : m_impl(new Impl()) {
+  connect(m_impl->m_scheduler.get(), &FrameScheduler::frameDue, this,
+          &AnimationHost::pullFrame);
+}
+
+AnimationHost::~AnimationHost() {}
+
+void AnimationHost::setInteractiveAnimation(
+    const InteractiveAnimation& interactiveAnimation,
+    const QPointF& mousePos) {
+  m_impl->m_inputQueue.take();
+  m_impl->m_opAnimation =
+      interactiveAnimation(triggerUserInput(mousePos, &m_impl->m_triggers));
+  m_impl->m_opLastFrame = boost::none;
+  m_impl->m_startTime.restart();
+  wake();
+}
+
+void AnimationHost::setTimeIndependent(bool timeIndependent) {
+  m_impl->m_timeIndependent = timeIndependent;
+  if (!timeIndependent)
+    m_impl->m_opLastFrame = boost::none;
+  wake();
+}
+
+void AnimationHost::setFrameOptimization(bool enabled) {
+  m_impl->m_optimizeFrames = enabled;
+}
+
+void AnimationHost::setFrameScheduler(
+    std::unique_ptr<FrameScheduler> scheduler) {
+  const bool active = m_impl->m_scheduler->isActive();
+  m_impl->m_scheduler = std::move(scheduler);
+  connect(m_impl->m_scheduler.get(), &FrameScheduler::frameDue, this,
+          &AnimationHost::pullFrame);
+  if (active)
+    m_impl->m_scheduler->start();
+}
+
+FrameScheduler& AnimationHost::frameScheduler() const {
+  return *m_impl->m_scheduler;
+}
+
+double AnimationHost::time() const {
+  return m_impl->m_startTime.nsecsElapsed() / 1e9;
+}
+
+void AnimationHost::postInput(const InputEvent& event) {
+  if (!m_impl->m_opAnimation)
+    return;
+  m_impl->m_inputQueue.push(event);
+  wake();
+}
+
+void AnimationHost::pullFrame() {
+  if (!m_impl->m_opAnimation)
+    return;
+  if (!m_impl->m_inputQueue.empty())
+    m_impl->m_triggers(m_impl->m_inputQueue.take());
+
+  // A time-independent animation can only change after user input, so once a
+  // frame without preceding input is unchanged, ticking is stopped until the
+  // next input.
+  const bool mayIdle =
+      m_impl->m_timeIndependent && !m_impl->m_inputSinceLastFrame;
+  m_impl->m_inputSinceLastFrame = false;
+
+  QElapsedTimer pullTimer;
+  pullTimer.start();
+  boost::optional<Drawing> opDrawing = m_impl->m_opAnimation->pull(time());
+  if (opDrawing && m_impl->m_optimizeFrames)
+    opDrawing = optimizeDrawing(*opDrawing);
+  const qint64 pullNsecs = pullTimer.nsecsElapsed();
+  if (!opDrawing) {
+    m_impl->m_opAnimation = boost::none;
+    m_impl->m_triggers = InputTriggers();
+    m_impl->m_opLastFrame = boost::none;
+    m_impl->m_scheduler->stop();
+  } else if (m_impl->m_timeIndependent) {
+    if (mayIdle && m_impl->m_opLastFrame &&
+        changedBounds(*m_impl->m_opLastFrame, *opDrawing).empty())
+      m_impl->m_scheduler->stop();
+    m_impl->m_opLastFrame = opDrawing;
+  }
+  Q_EMIT framePulled(opDrawing, pullNsecs);
+}
+
+void AnimationHost::wake() {
+  m_impl->m_inputSinceLastFrame = true;
+  if (m_impl->m_opAnimation)
+    m_impl->m_scheduler->start();
+}
+}
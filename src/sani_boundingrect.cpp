@@ -0,0 +1,282 @@
+#include <sani/boundingrect.hpp>
+
+#include <QFontMetricsF>
+#include <QTransform>
+#include <algorithm>
+#include <vector>
+
+namespace sani {
+
+namespace {
+// Margin, in device pixels, by which antialiasing may extend any primitive.
+const qreal antialiasingMargin = 1.0;
+
+const qreal sqrt2 = 1.4142135623730951;
+
+// Return the smallest rectangle containing both the specified 'a' and 'b'.
+// Unlike 'QRectF::united', rectangles with a zero width or height are not
+// ignored.
+QRectF unite(const QRectF& a, const QRectF& b) {
+  const QRectF na = a.normalized();
+  const QRectF nb = b.normalized();
+  return QRectF(QPointF(std::min(na.left(), nb.left()),
+                        std::min(na.top(), nb.top())),
+                QPointF(std::max(na.right(), nb.right()),
+                        std::max(na.bottom(), nb.bottom())));
+}
+
+// Return the bounds of a drawing that consists of both the specified 'a' and
+// 'b'.
+DrawingBounds unite(const DrawingBounds& a, const DrawingBounds& b) {
+  if (a.isEmpty)
+    return b;
+  if (b.isEmpty)
+    return a;
+  return DrawingBounds(unite(a.rect, b.rect),
+                       std::max(a.cosmeticMargin, b.cosmeticMargin));
+}
+
+// Return the bounds of the specified 'geometry' when stroked with the
+// specified 'pen'.
+DrawingBounds stroked(const QRectF& geometry, const QPen& pen) {
+  if (pen.style() == Qt::NoPen)
+    return DrawingBounds(geometry.normalized(), antialiasingMargin);
+
+  // Square caps and miter joins reach further than half the pen width from
+  // the stroked geometry.
+  qreal reach = 1.0;
+  if (pen.capStyle() == Qt::SquareCap)
+    reach = std::max(reach, sqrt2);
+  if (pen.joinStyle() == Qt::MiterJoin || pen.joinStyle() == Qt::SvgMiterJoin)
+    reach = std::max(reach, std::max(pen.miterLimit(), sqrt2));
+
+  if (pen.isCosmetic()) {
+    const qreal halfWidth = std::max(pen.widthF(), qreal(1.0)) / 2.0;
+    return DrawingBounds(geometry.normalized(),
+                         halfWidth * reach + antialiasingMargin);
+  } else {
+    const qreal margin = pen.widthF() / 2.0 * reach;
+    return DrawingBounds(
+        geometry.normalized().adjusted(-margin, -margin, margin, margin),
+        antialiasingMargin);
+  }
+}
+
+// This class implements a function object that computes the bounds of a
+// primitive.
+struct PrimitiveBounds {
+  DrawingBounds operator()(const DrawPoint& d) const {
+    return stroked(QRectF(d.p, d.p), d.pen);
+  }
+  DrawingBounds operator()(const DrawLine& d) const {
+    return stroked(QRectF(d.p1, d.p2), d.pen);
+  }
+  DrawingBounds operator()(const DrawRect& d) const {
+    return stroked(d.rect, d.pen);
+  }
+  DrawingBounds operator()(const DrawRoundedRect& d) const {
+    return stroked(d.rect, d.pen);
+  }
+  DrawingBounds operator()(const DrawText& d) const {
+    if (d.text.empty())
+      return DrawingBounds();
+    const QRectF textRect =
+        QFontMetricsF(d.font)
+            .boundingRect(QString::fromUtf8(d.text.data(), int(d.text.size())));
+    return DrawingBounds(textRect.translated(d.position), antialiasingMargin);
+  }
+  DrawingBounds operator()(const DrawEllipse& d) const {
+    return stroked(d.rect, d.pen);
+  }
+  DrawingBounds operator()(const DrawArc& d) const {
+    return stroked(d.rect, d.pen);
+  }
+  DrawingBounds operator()(const DrawPie& d) const {
+    return stroked(d.rect, d.pen);
+  }
+  DrawingBounds operator()(const DrawChord& d) const {
+    return stroked(d.rect, d.pen);
+  }
+};
+
+// A unit of pending work of 'drawingBounds'.
+struct Task {
+  Task(const Drawing* d_, bool combine_) : d(d_), combine(combine_) {}
+
+  const Drawing* d;  // Drawing to compute the bounds of
+  bool combine;      // If 'true', the bounds of the children of 'd' are on top
+                     // of the value stack and only need to be combined.
+};
+
+// This class implements a visitor that pushes the bounds of a drawing node
+// onto a value stack if they are known, and otherwise schedules the node's
+// children followed by combining their bounds.
+class Enter : public boost::static_visitor<> {
+ public:
+  Enter(const Drawing& node,
+        std::vector<Task>& tasks,
+        std::vector<DrawingBounds>& values)
+      : m_node(node), m_tasks(tasks), m_values(values) {}
+
+  template <typename Leaf>
+  void operator()(const Leaf& d) const {
+    m_values.push_back(PrimitiveBounds()(d));
+  }
+  void operator()(const DrawNothing&) const {
+    m_values.push_back(DrawingBounds());
+  }
+  void operator()(const DrawCached& d) const { enter(*d.d); }
+  void operator()(const DrawOver& d) const {
+    if (known(d.boundsCache))
+      return;
+    enter(*d.d1);
+    enter(*d.d2);
+  }
+  void operator()(const DrawTransform& d) const {
+    if (!known(d.boundsCache))
+      enter(*d.d);
+  }
+  void operator()(const DrawInstances& d) const {
+    if (!known(d.boundsCache))
+      enter(*d.d);
+  }
+  void operator()(const DrawGroup& d) const {
+    if (known(d.boundsCache))
+      return;
+    for (const Drawing& child : *d.children)
+      enter(child);
+  }
+  void operator()(const DrawLOD& d) const {
+    if (known(d.boundsCache))
+      return;
+    for (const Drawing& level : *d.levels)
+      enter(level);
+  }
+
+ private:
+  // Push the bounds held by the specified 'cache' and return 'true', or
+  // schedule combining the bounds of the children of the current node and
+  // return 'false' if there are none yet.
+  bool known(const BoundsCache& cache) const {
+    if (const DrawingBounds* const cached = cache.get()) {
+      m_values.push_back(*cached);
+      return true;
+    }
+    m_tasks.push_back(Task(&m_node, true));
+    return false;
+  }
+
+  // Schedule computing the bounds of the specified 'd'.
+  void enter(const Drawing& d) const { m_tasks.push_back(Task(&d, false)); }
+
+  const Drawing& m_node;
+  std::vector<Task>& m_tasks;
+  std::vector<DrawingBounds>& m_values;
+};
+
+// This class implements a visitor that replaces the bounds of the children of
+// a composite drawing node on top of a value stack by the bounds of the node,
+// and caches them in the node.
+class Combine : public boost::static_visitor<> {
+ public:
+  explicit Combine(std::vector<DrawingBounds>& values) : m_values(values) {}
+
+  template <typename T>
+  void operator()(const T&) const {}
+  void operator()(const DrawOver& d) const {
+    const DrawingBounds b = pop();
+    const DrawingBounds a = pop();
+    m_values.push_back(d.boundsCache.set(unite(a, b)));
+  }
+  void operator()(const DrawTransform& d) const {
+    DrawingBounds result = pop();
+    if (!result.isEmpty)
+      result.rect = d.t.mapRect(result.rect);
+    m_values.push_back(d.boundsCache.set(result));
+  }
+  void operator()(const DrawInstances& d) const {
+    const DrawingBounds instance = pop();
+    DrawingBounds result;
+    if (!instance.isEmpty) {
+      for (const QTransform& t : *d.transforms)
+        result = unite(result, DrawingBounds(t.mapRect(instance.rect),
+                                             instance.cosmeticMargin));
+    }
+    m_values.push_back(d.boundsCache.set(result));
+  }
+  void operator()(const DrawGroup& d) const {
+    DrawingBounds result;
+    for (std::size_t i = d.children->size(); i > 0; --i)
+      result = unite(result, pop());
+    m_values.push_back(d.boundsCache.set(result));
+  }
+  void operator()(const DrawLOD& d) const {
+    DrawingBounds result;
+    for (std::size_t i = d.levels->size(); i > 0; --i)
+      result = unite(result, pop());
+    m_values.push_back(d.boundsCache.set(result));
+  }
+
+ private:
+  DrawingBounds pop() const {
+    const DrawingBounds result = m_values.back();
+    m_values.pop_back();
+    return result;
+  }
+
+  std::vector<DrawingBounds>& m_values;
+};
+}
+
+BoundsCache::BoundsCache() : m_bounds(nullptr) {}
+
+BoundsCache::BoundsCache(const BoundsCache&) : m_bounds(nullptr) {}
+
+BoundsCache& BoundsCache::operator=(const BoundsCache&) {
+  delete m_bounds.exchange(nullptr);
+  return *this;
+}
+
+BoundsCache::~BoundsCache() { delete m_bounds.load(); }
+
+const DrawingBounds* BoundsCache::get() const {
+  return m_bounds.load(std::memory_order_acquire);
+}
+
+const DrawingBounds& BoundsCache::set(const DrawingBounds& bounds) const {
+  const DrawingBounds* const fresh = new DrawingBounds(bounds);
+  const DrawingBounds* expected = nullptr;
+  if (m_bounds.compare_exchange_strong(expected, fresh,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire))
+    return *fresh;
+  delete fresh;
+  return *expected;
+}
+
+DrawingBounds drawingBounds(const Drawing& d) {
+  std::vector<Task> tasks(1, Task(&d, false));
+  std::vector<DrawingBounds> values;
+  while (!tasks.empty()) {
+    const Task task = tasks.back();
+    tasks.pop_back();
+    if (task.combine)
+      boost::apply_visitor(Combine(values), *task.d);
+    else
+      boost::apply_visitor(Enter(*task.d, tasks, values), *task.d);
+  }
+  return values.back();
+}
+
+QRectF boundingRect(const Drawing& d) {
+  const DrawingBounds bounds = drawingBounds(d);
+  return bounds.isEmpty ? QRectF() : bounds.rect;
+}
+
+QRectF deviceRect(const DrawingBounds& bounds, const QTransform& toDevice) {
+  if (bounds.isEmpty)
+    return QRectF();
+  const qreal m = bounds.cosmeticMargin;
+  return toDevice.mapRect(bounds.rect).adjusted(-m, -m, m, m);
+}
+}
@@ -0,0 +1,294 @@
+#include <sani/displaylist.hpp>
+
+#include <sani/painterstatecache.hpp>
+
+#include <QLineF>
+#include <QPainter>
+
+namespace sani {
+
+namespace {
+// A subtree of a 'Drawing' that remains to be compiled, with the index of its
+// transform and the colour, if any, that replaces its pens' and brushes'.
+struct Pending {
+  Pending(const Drawing* d_, std::size_t transformIndex_, const QColor* color_)
+      : d(d_), transformIndex(transformIndex_), color(color_) {}
+
+  const Drawing* d;
+  std::size_t transformIndex;
+  const QColor* color;
+};
+
+// This class implements a visitor that appends the primitives of a drawing
+// node to a 'DisplayList', optionally replacing the colour of their pens and
+// brushes, and schedules the children of composite nodes on a stack so that
+// they are compiled in painting order.
+class Compile : public boost::static_visitor<> {
+ public:
+  Compile(DisplayList& displayList,
+          std::vector<Pending>& pending,
+          const Pending& current,
+          const QTransform& toDevice)
+      : m_displayList(displayList),
+        m_pending(pending),
+        m_current(current),
+        m_toDevice(toDevice) {}
+
+  template <typename Leaf>
+  void operator()(const Leaf& d) const {
+    m_displayList.commands.push_back(
+        DisplayList::Command(m_current.transformIndex, d));
+    if (m_current.color)
+      recolor(m_displayList.commands.back().primitive, *m_current.color);
+  }
+
+  void operator()(const DrawNothing&) const {}
+
+  void operator()(const DrawCached& d) const {
+    // A recoloured drawing cannot use the cached image.
+    if (m_current.color) {
+      push(*d.d, m_current.transformIndex, m_current.color);
+    } else {
+      m_displayList.commands.push_back(
+          DisplayList::Command(m_current.transformIndex, d));
+    }
+  }
+
+  void operator()(const DrawOver& d) const {
+    push(*d.d1, m_current.transformIndex, m_current.color);
+    push(*d.d2, m_current.transformIndex, m_current.color);
+  }
+
+  void operator()(const DrawGroup& d) const {
+    const std::vector<Drawing>& children = *d.children;
+    for (std::size_t i = children.size(); i > 0; --i)
+      push(children[i - 1], m_current.transformIndex, m_current.color);
+  }
+
+  void operator()(const DrawLOD& d) const {
+    const QTransform& t = m_displayList.transforms[m_current.transformIndex];
+    if (const Drawing* const level = lodLevel(d, lodScale(t * m_toDevice)))
+      push(*level, m_current.transformIndex, m_current.color);
+  }
+
+  void operator()(const DrawTransform& d) const {
+    if (d.t.isIdentity())
+      push(*d.d, m_current.transformIndex, m_current.color);
+    else
+      push(*d.d, appendTransform(d.t), m_current.color);
+  }
+
+  void operator()(const DrawInstances& d) const {
+    const std::vector<QTransform>& transforms = *d.transforms;
+    const std::vector<QColor>& colors = *d.colors;
+    // The transforms are appended in painting order, the instances are
+    // scheduled in reverse.
+    const std::size_t firstIndex = m_displayList.transforms.size();
+    for (const QTransform& t : transforms)
+      appendTransform(t);
+    for (std::size_t i = transforms.size(); i > 0; --i) {
+      // An enclosing recolouring applies to the whole template.
+      const QColor* const color = m_current.color || colors.empty()
+                                      ? m_current.color
+                                      : &colors[i - 1];
+      push(*d.d, firstIndex + i - 1, color);
+    }
+  }
+
+ private:
+  // Schedule compiling the specified 'd' with the specified 'transformIndex'
+  // and 'color' after the work scheduled so far for the current node.
+  void push(const Drawing& d,
+            std::size_t transformIndex,
+            const QColor* color) const {
+    m_pending.push_back(Pending(&d, transformIndex, color));
+  }
+
+  // Append the specified 't', applied before the current transform, to the
+  // transforms of the display list and return its index.
+  std::size_t appendTransform(const QTransform& t) const {
+    const std::size_t index = m_displayList.transforms.size();
+    m_displayList.transforms.push_back(
+        t * m_displayList.transforms[m_current.transformIndex]);
+    return index;
+  }
+
+  DisplayList& m_displayList;
+  std::vector<Pending>& m_pending;
+  const Pending m_current;
+  const QTransform& m_toDevice;
+};
+
+// Return 'true' if the specified 'a' and 'b' can be painted with the same
+// painter state, otherwise return 'false'.
+bool sameStyle(const DrawPoint& a, const DrawPoint& b) {
+  return a.pen == b.pen;
+}
+
+bool sameStyle(const DrawLine& a, const DrawLine& b) { return a.pen == b.pen; }
+
+bool sameStyle(const DrawRect& a, const DrawRect& b) {
+  return a.pen == b.pen && a.brush == b.brush;
+}
+
+bool sameStyle(const DrawEllipse& a, const DrawEllipse& b) {
+  return a.pen == b.pen && a.brush == b.brush;
+}
+
+// Return the index one past the last command of the run in the specified
+// 'commands' that starts at the specified 'begin'. A run is a maximal sequence
+// of commands that hold a 'T' and share the transform and style of
+// 'commands[begin]', which must hold a 'T'.
+template <typename T>
+std::size_t runEnd(const std::vector<DisplayList::Command>& commands,
+                   const std::size_t begin) {
+  const DisplayList::Command& first = commands[begin];
+  const T& firstPrimitive = boost::get<T>(first.primitive);
+  std::size_t end = begin + 1;
+  while (end < commands.size() &&
+         commands[end].transformIndex == first.transformIndex) {
+    const T* const primitive = boost::get<T>(&commands[end].primitive);
+    if (!primitive || !sameStyle(firstPrimitive, *primitive))
+      break;
+    ++end;
+  }
+  return end;
+}
+
+// This class implements a visitor that paints the run of commands starting at
+// a given command and returns the index of the first command after that run.
+struct PaintRun : boost::static_visitor<std::size_t> {
+  PaintRun(const std::vector<DisplayList::Command>& commands,
+           std::size_t begin,
+           PainterStateCache& state,
+           std::vector<QLineF>& lineBuffer,
+           std::vector<QPointF>& pointBuffer,
+           std::vector<QRectF>& rectBuffer)
+      : m_commands(commands),
+        m_begin(begin),
+        m_state(state),
+        m_lineBuffer(lineBuffer),
+        m_pointBuffer(pointBuffer),
+        m_rectBuffer(rectBuffer) {}
+
+  template <typename T>
+  std::size_t operator()(const T&) const {
+    paintPrimitive(m_commands[m_begin].primitive, m_state);
+    return m_begin + 1;
+  }
+
+  std::size_t operator()(const DrawPoint& first) const {
+    // 'drawPoints' composites overlapping points once, so only opaque points
+    // can be merged without changing the output.
+    const std::size_t end = first.pen.brush().isOpaque()
+                                ? runEnd<DrawPoint>(m_commands, m_begin)
+                                : m_begin + 1;
+    m_pointBuffer.clear();
+    for (std::size_t i = m_begin; i < end; ++i)
+      m_pointBuffer.push_back(
+          boost::get<DrawPoint>(m_commands[i].primitive).p);
+    m_state.setPen(first.pen);
+    m_state.painter().drawPoints(m_pointBuffer.data(),
+                                 int(m_pointBuffer.size()));
+    return end;
+  }
+
+  std::size_t operator()(const DrawLine& first) const {
+    // 'drawLines' strokes all the lines as a single path, so only opaque lines
+    // can be merged without changing the output.
+    const std::size_t end = first.pen.brush().isOpaque()
+                                ? runEnd<DrawLine>(m_commands, m_begin)
+                                : m_begin + 1;
+    m_lineBuffer.clear();
+    for (std::size_t i = m_begin; i < end; ++i) {
+      const DrawLine& line = boost::get<DrawLine>(m_commands[i].primitive);
+      m_lineBuffer.push_back(QLineF(line.p1, line.p2));
+    }
+    m_state.setPen(first.pen);
+    m_state.painter().drawLines(m_lineBuffer.data(), int(m_lineBuffer.size()));
+    return end;
+  }
+
+  std::size_t operator()(const DrawRect& first) const {
+    const std::size_t end = runEnd<DrawRect>(m_commands, m_begin);
+    m_rectBuffer.clear();
+    for (std::size_t i = m_begin; i < end; ++i)
+      m_rectBuffer.push_back(
+          boost::get<DrawRect>(m_commands[i].primitive).rect);
+    m_state.setPen(first.pen);
+    m_state.setBrush(first.brush);
+    m_state.painter().drawRects(m_rectBuffer.data(), int(m_rectBuffer.size()));
+    return end;
+  }
+
+  std::size_t operator()(const DrawEllipse& first) const {
+    // There is no array overload for ellipses, but the style of the run still
+    // only needs to be set once.
+    const std::size_t end = runEnd<DrawEllipse>(m_commands, m_begin);
+    m_state.setPen(first.pen);
+    m_state.setBrush(first.brush);
+    for (std::size_t i = m_begin; i < end; ++i)
+      m_state.painter().drawEllipse(
+          boost::get<DrawEllipse>(m_commands[i].primitive).rect);
+    return end;
+  }
+
+  const std::vector<DisplayList::Command>& m_commands;
+  const std::size_t m_begin;
+  PainterStateCache& m_state;
+  std::vector<QLineF>& m_lineBuffer;
+  std::vector<QPointF>& m_pointBuffer;
+  std::vector<QRectF>& m_rectBuffer;
+};
+}
+
+DisplayList::DisplayList() : transforms(1, QTransform()) {}
+
+DisplayList compile(const Drawing& d, const QTransform& toDevice) {
+  DisplayList result;
+  std::vector<Pending> pending(1, Pending(&d, 0, 0));
+  while (!pending.empty()) {
+    const Pending current = pending.back();
+    pending.pop_back();
+    boost::apply_visitor(Compile(result, pending, current, toDevice),
+                         *current.d);
+  }
+  return result;
+}
+
+void draw(const DisplayList& displayList, QPainter& painter) {
+  const QTransform baseTransform = painter.worldTransform();
+  std::size_t currentIndex = 0;
+  for (const DisplayList::Command& command : displayList.commands) {
+    if (command.transformIndex != currentIndex) {
+      currentIndex = command.transformIndex;
+      painter.setWorldTransform(displayList.transforms[currentIndex] *
+                                baseTransform);
+    }
+    paintPrimitive(command.primitive, painter);
+  }
+  painter.setWorldTransform(baseTransform);
+}
+
+void drawBatched(const DisplayList& displayList, QPainter& painter) {
+  const QTransform baseTransform = painter.worldTransform();
+  PainterStateCache state(painter);
+  std::vector<QLineF> lineBuffer;
+  std::vector<QPointF> pointBuffer;
+  std::vector<QRectF> rectBuffer;
+  const std::vector<DisplayList::Command>& commands = displayList.commands;
+  std::size_t currentIndex = 0;
+  std::size_t i = 0;
+  while (i < commands.size()) {
+    if (commands[i].transformIndex != currentIndex) {
+      currentIndex = commands[i].transformIndex;
+      state.setWorldTransform(displayList.transforms[currentIndex] *
+                              baseTransform);
+    }
+    i = boost::apply_visitor(PaintRun(commands, i, state, lineBuffer,
+                                      pointBuffer, rectBuffer),
+                             commands[i].primitive);
+  }
+  state.setWorldTransform(baseTransform);
+}
+}
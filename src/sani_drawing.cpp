@@ -1,231 +1,482 @@
 #include <sani/drawing.hpp>
 
-#include <boost/bind.hpp>
+#include <sani/boundingrect.hpp>
+#include <sani/drawinghash.hpp>
+#include <sani/painterstatecache.hpp>
+#include <sani/primitive.hpp>
+
 #include <QPainter>
 
+#include <algorithm>
+#include <cmath>
+
 namespace sani {
 
-    // Return the specified 'degreesValue', which is in degrees units, in 16ths of a degree units. Note that 16ths of a degree is the standard angle unit in the Qt library.
-    static int degToDeg16( const qreal & r )
+    // The children of destroyed drawing nodes that the current thread has yet
+    // to release
+    struct PendingChildren
+    {
+        PendingChildren()
+            : releasing( false )
+        {
+        }
+        std::vector< std::shared_ptr< const void > > children;
+        bool releasing;  // 'true' while 'children' is being emptied
+    };
+    // Moves the children of a composite node that are owned by nothing else
+    // onto a 'PendingChildren' stack.
+    class TakeChildren
+        : public boost::static_visitor<>
+    {
+    public:
+        explicit TakeChildren( PendingChildren & pending_ )
+            : pending( pending_ )
+        {
+        }
+        template< typename T >
+        void operator()( T & ) const
+        {
+        }
+        void operator()( DrawOver & d ) const
+        {
+            take( d.d1 );
+            take( d.d2 );
+        }
+        void operator()( DrawTransform & d ) const { take( d.d ); }
+        void operator()( DrawCached & d ) const { take( d.d ); }
+        void operator()( DrawInstances & d ) const { take( d.d ); }
+        void operator()( DrawGroup & d ) const { take( d.children ); }
+        void operator()( DrawLOD & d ) const { take( d.levels ); }
+    private:
+        template< typename T >
+        void take( std::shared_ptr< const T > & child ) const
+        {
+            if( child.use_count() == 1 )
+                pending.children.push_back( std::move( child ) );
+        }
+        PendingChildren & pending;
+    };
+
+    void detail::releaseChildren( Drawing & d )
     {
-        return r * 16;
+        static thread_local PendingChildren pending;
+        boost::apply_visitor( TakeChildren( pending ), d );
+        if( pending.releasing )
+            return;
+        // Destroying a child may push its own children, which this loop then
+        // releases in turn.
+        pending.releasing = true;
+        while( !pending.children.empty() )
+        {
+            const std::shared_ptr< const void > child
+                = std::move( pending.children.back() );
+            pending.children.pop_back();
+        }
+        pending.releasing = false;
     }
 
-    Drawing drawLine( const QPen & pen, const QPointF & p1, const QPointF & p2 )
+    Drawing drawLine( QPen pen, const QPointF & p1, const QPointF & p2 )
     {
-        return DrawLine( pen, p1, p2 );
+        return DrawLine( std::move( pen ), p1, p2 );
     }
-    Drawing drawPoint( const QPen & pen, const QPointF & p )
+    Drawing drawPoint( QPen pen, const QPointF & p )
     {
-        return DrawPoint( pen, p );
+        return DrawPoint( std::move( pen ), p );
     }
-    Drawing drawRect( const QPen & pen, const QBrush & brush, const QRectF & rect )
+    Drawing drawRect( QPen pen, QBrush brush, const QRectF & rect )
     {
-        return DrawRect( pen, brush, rect );
+        return DrawRect( std::move( pen ), std::move( brush ), rect );
     }
-    Drawing drawEllipse( const QPen & pen, const QBrush & brush, const QRectF & rect )
+    Drawing drawEllipse( QPen pen, QBrush brush, const QRectF & rect )
     {
-        return DrawEllipse( pen, brush, rect );
+        return DrawEllipse( std::move( pen ), std::move( brush ), rect );
     }
     Drawing drawRoundedRect
-        ( const QPen & pen
-        , const QBrush & brush
+        ( QPen pen
+        , QBrush brush
         , const QRectF & rect
         , const double & xRadius
         , const double & yRadius
         , const bool absolute
         )
     {
-        return DrawRoundedRect( pen, brush, rect, xRadius, yRadius, absolute );
+        return DrawRoundedRect
+            ( std::move( pen )
+            , std::move( brush )
+            , rect
+            , xRadius
+            , yRadius
+            , absolute
+            );
     }
     Drawing drawText
-        ( const QPen & pen
-        , const QBrush & brush
-        , const QFont & font
+        ( QPen pen
+        , QBrush brush
+        , QFont font
         , const QPointF & position
-        , const std::string & text
+        , std::string text
         )
     {
-        return DrawText( pen, brush, font, position, text );
+        return DrawText
+            ( std::move( pen )
+            , std::move( brush )
+            , std::move( font )
+            , position
+            , std::move( text )
+            );
     }
     Drawing drawArc
-        ( const QPen & pen
-        , const QBrush & brush
+        ( QPen pen
+        , QBrush brush
         , const QRectF & rect
         , const double & startAngle
         , const double & spanAngle
         )
     {
-        return DrawArc( pen, brush, rect, startAngle, spanAngle );
+        return DrawArc
+            ( std::move( pen )
+            , std::move( brush )
+            , rect
+            , startAngle
+            , spanAngle
+            );
     }
     Drawing drawPie
-        ( const QPen & pen
-        , const QBrush & brush
+        ( QPen pen
+        , QBrush brush
         , const QRectF & rect
         , const double & startAngle
         , const double & spanAngle
         )
     {
-        return DrawPie( pen, brush, rect, startAngle, spanAngle );
+        return DrawPie
+            ( std::move( pen )
+            , std::move( brush )
+            , rect
+            , startAngle
+            , spanAngle
+            );
     }
     Drawing drawChord
-        ( const QPen & pen
-        , const QBrush & brush
+        ( QPen pen
+        , QBrush brush
         , const QRectF & rect
         , const double & startAngle
         , const double & spanAngle
         )
     {
-        return DrawChord( pen, brush, rect, startAngle, spanAngle );
+        return DrawChord
+            ( std::move( pen )
+            , std::move( brush )
+            , rect
+            , startAngle
+            , spanAngle
+            );
     }
-    Drawing drawOver( const Drawing & a, const Drawing & b )
+    Drawing drawOver( Drawing a, Drawing b )
     {
-        return DrawOver( a, b );
+        return DrawOver( std::move( a ), std::move( b ) );
     }
-    Drawing transformDrawing( const QTransform & t, const Drawing & d )
+    Drawing transformDrawing( const QTransform & t, Drawing d )
     {
-        return DrawTransform( t, d );
+        return DrawTransform( t, std::move( d ) );
     }
-    struct Draw
+    Drawing cachedDrawing( Drawing d )
     {
+        const std::size_t hash = hash_value( d );
+        return DrawCached( std::move( d ), hash );
+    }
+    Drawing drawInstances
+        ( Drawing d
+        , std::vector< QTransform > transforms
+        , std::vector< QColor > colors
+        )
+    {
+        return DrawInstances
+            ( std::move( d )
+            , std::move( transforms )
+            , std::move( colors )
+            );
+    }
+    Drawing drawAll( std::vector< Drawing > ds )
+    {
+        return DrawGroup( std::move( ds ) );
+    }
+    Drawing drawLOD( std::vector< std::pair< double, Drawing > > levels )
+    {
+        std::stable_sort
+            ( levels.begin()
+            , levels.end()
+            , []
+                ( const std::pair< double, Drawing > & a
+                , const std::pair< double, Drawing > & b
+                )
+              {
+                  return a.first > b.first;
+              }
+            );
+        std::vector< Drawing > drawings;
+        std::vector< double > minScales;
+        drawings.reserve( levels.size() );
+        minScales.reserve( levels.size() );
+        for( std::pair< double, Drawing > & level : levels )
+        {
+            minScales.push_back( level.first );
+            drawings.push_back( std::move( level.second ) );
+        }
+        return DrawLOD( std::move( drawings ), std::move( minScales ) );
+    }
+    const Drawing * lodLevel( const DrawLOD & d, double scale )
+    {
+        const std::vector< double > & minScales = *d.minScales;
+        for( std::size_t i = 0; i < minScales.size(); ++i )
+            if( scale >= minScales[ i ] )
+                return &( *d.levels )[ i ];
+        return 0;
+    }
+    double lodScale( const QTransform & toDevice )
+    {
+        return std::sqrt( std::abs( toDevice.m11() * toDevice.m22()
+                                  - toDevice.m12() * toDevice.m21() ) );
+    }
+    // Draws a 'Drawing', skipping the subtrees that lie outside of an
+    // optional rectangle in device coordinates, and replacing the colour of
+    // every pen and brush by an optional colour. Composite nodes push the work
+    // for their children onto an explicit stack instead of recursing.
+    //
+    // Nested transforms are concatenated on an explicit matrix stack rather
+    // than with 'QPainter::save' and 'QPainter::restore', which copy the whole
+    // painter state. The painter's world transform, pen, brush, and font are
+    // only changed, through a 'PainterStateCache', right before painting a
+    // primitive that needs a different value.
+    class Draw
+    {
+    public:
         typedef void result_type;
-        void operator()
-            ( QPainter & painter
-            , const DrawPoint & d
-            ) const
-        {
-            painter.setPen( d.pen );
-            painter.drawPoint( d.p );
-        }
-        void operator()
-            ( QPainter & painter
-            , const DrawLine & d
-            ) const
-        {
-            painter.setPen( d.pen );
-            painter.drawLine( d.p1, d.p2 );
-        }
-        void operator()
-            ( QPainter & painter
-            , const DrawRect & d
-            ) const
-        {
-            painter.setPen( d.pen );
-            painter.setBrush( d.brush );
-            painter.drawRect( d.rect );
-        }
-        void operator()
-            ( QPainter & painter
-            , const DrawRoundedRect & d
-            ) const
-        {
-            painter.setPen( d.pen );
-            painter.setBrush( d.brush );
-            painter.drawRoundedRect
-                ( d.rect
-                , d.xRadius
-                , d.yRadius
-                , d.absolute
-                    ? Qt::AbsoluteSize
-                    : Qt::RelativeSize
+        Draw( QPainter & painter_, const QRectF * deviceCullRect_ )
+            : state( painter_ )
+            , deviceCullRect( deviceCullRect_ )
+            , color( 0 )
+        {
+            matrices.push_back
+                ( Matrices
+                    ( painter_.worldTransform()
+                    , painter_.combinedTransform()
+                    )
                 );
         }
-        void operator()
-            ( QPainter & painter
-            , const DrawText & d
-            ) const
-        {
-            painter.setPen( d.pen );
-            painter.setBrush( d.brush );
-            painter.setFont( d.font );
-            painter.drawText
-                ( d.position
-                , QString::fromUtf8( d.text.data(), int( d.text.size() ) )
-                );
+        // Draw the specified 'd' unless it lies outside of 'deviceCullRect'.
+        void run( const Drawing & d )
+        {
+            tasks.push_back( Task( Task::e_VISIT, &d, 0 ) );
+            while( !tasks.empty() )
+            {
+                const Task task = tasks.back();
+                tasks.pop_back();
+                switch( task.kind )
+                {
+                case Task::e_VISIT:
+                    if( !deviceCullRect
+                     || deviceRect
+                            ( drawingBounds( *task.d )
+                            , matrices.back().toDevice
+                            ).intersects( *deviceCullRect )
+                      )
+                    {
+                        color = task.color;
+                        boost::apply_visitor( *this, *task.d );
+                    }
+                    break;
+                case Task::e_PAINT:
+                    color = task.color;
+                    boost::apply_visitor( *this, *task.d );
+                    break;
+                case Task::e_POP_MATRICES:
+                    matrices.pop_back();
+                    break;
+                case Task::e_NEXT_INSTANCE:
+                    nextInstance( task );
+                    break;
+                }
+            }
+            state.setWorldTransform( matrices.front().world );
         }
-        void operator()
-            ( QPainter & painter
-            , const DrawEllipse & d
-            ) const
-        {
-            painter.setPen( d.pen );
-            painter.setBrush( d.brush );
-            painter.drawEllipse( d.rect );
-        }
-        void operator()
-            ( QPainter & painter
-            , const DrawArc & d
-            ) const
-        {
-            painter.setPen( d.pen );
-            painter.setBrush( d.brush );
-            painter.drawArc
-                ( d.rect
-                , degToDeg16( d.startAngle )
-                , degToDeg16( d.spanAngle )
-                );
+        template< typename Leaf >
+        void operator()( const Leaf & d )
+        {
+            state.setWorldTransform( matrices.back().world );
+            if( color )
+            {
+                Primitive p( d );
+                recolor( p, *color );
+                paintPrimitive( p, state );
+            }
+            else
+                paintPrimitive( d, state );
         }
-        void operator()
-            ( QPainter & painter
-            , const DrawPie & d
-            ) const
-        {
-            painter.setPen( d.pen );
-            painter.setBrush( d.brush );
-            painter.drawPie
-                ( d.rect
-                , degToDeg16( d.startAngle )
-                , degToDeg16( d.spanAngle )
-                );
+        void operator()( const DrawCached & d )
+        {
+            // A recoloured drawing cannot use the cached image.
+            if( color )
+                push( *d.d );
+            else
+            {
+                state.setWorldTransform( matrices.back().world );
+                paintPrimitive( d, state );
+            }
         }
-        void operator()
-            ( QPainter & painter
-            , const DrawChord & d
-            ) const
-        {
-            painter.setPen( d.pen );
-            painter.setBrush( d.brush );
-            painter.drawChord
-                ( d.rect
-                , degToDeg16( d.startAngle )
-                , degToDeg16( d.spanAngle )
-                );
+        void operator()( const DrawNothing & )
+        {
         }
-        void operator()
-            ( QPainter & painter
-            , const DrawNothing &
-            ) const
+        void operator()( const DrawOver & d )
         {
+            push( *d.d1 );
+            push( *d.d2 );
         }
-        void operator()
-            ( QPainter & painter
-            , const DrawOver & d
-            ) const
+        void operator()( const DrawGroup & d )
         {
-            draw( d.d2, painter );
-            draw( d.d1, painter );
+            const std::vector< Drawing > & children = *d.children;
+            for( std::size_t i = children.size(); i > 0; --i )
+                push( children[ i - 1 ] );
         }
-        void operator()
-            ( QPainter & painter
-            , const DrawTransform & t
-            ) const
+        void operator()( const DrawLOD & d )
         {
-            painter.save();
-            painter.setTransform( t.t, true );
-            draw( t.d, painter );
-            painter.restore();
+            if( const Drawing * const level =
+                    lodLevel( d, lodScale( matrices.back().toDevice ) ) )
+                push( *level );
         }
+        void operator()( const DrawTransform & t )
+        {
+            if( t.t.isIdentity() )
+            {
+                push( *t.d );
+                return;
+            }
+            pushMatrices( t.t );
+            tasks.push_back( Task( Task::e_POP_MATRICES, 0, 0 ) );
+            push( *t.d );
+        }
+        // Stamp the template once per instance by only changing the current
+        // matrices in between.
+        void operator()( const DrawInstances & d )
+        {
+            const DrawingBounds bounds = drawingBounds( *d.d );
+            if( bounds.isEmpty || d.transforms->empty() )
+                return;
+            instanceBounds.push_back( bounds );
+            Task next( Task::e_NEXT_INSTANCE, d.d.get(), color );
+            next.instances = &d;
+            next.index = 0;
+            tasks.push_back( next );
+        }
+    private:
+        // A unit of pending work.
+        struct Task
+        {
+            enum Kind
+            {
+                e_VISIT,          // Cull and paint 'd'.
+                e_PAINT,          // Paint 'd' without culling it.
+                e_POP_MATRICES,   // Return to the enclosing transform.
+                e_NEXT_INSTANCE   // Paint instance 'index' of 'instances' or
+                                  // a later one.
+            };
+            Task( Kind kind_, const Drawing * d_, const QColor * color_ )
+                : kind( kind_ )
+                , d( d_ )
+                , color( color_ )
+                , instances( 0 )
+                , index( 0 )
+            {
+            }
+            Kind kind;
+            const Drawing * d;
+            const QColor * color;
+            const DrawInstances * instances;
+            std::size_t index;
+        };
+        // The transforms from the coordinates of the drawing being visited to
+        // the painter's world coordinates and to device coordinates.
+        struct Matrices
+        {
+            Matrices( const QTransform & world_, const QTransform & toDevice_ )
+                : world( world_ )
+                , toDevice( toDevice_ )
+            {
+            }
+            QTransform world;
+            QTransform toDevice;
+        };
+        // Schedule the specified 'd' to be painted with the current colour
+        // after the work scheduled so far by the current node.
+        void push( const Drawing & d )
+        {
+            tasks.push_back( Task( Task::e_VISIT, &d, color ) );
+        }
+        // Make the specified 't', applied before the current transform, the
+        // current transform.
+        void pushMatrices( const QTransform & t )
+        {
+            const Matrices & current = matrices.back();
+            matrices.push_back
+                ( Matrices( t * current.world, t * current.toDevice ) );
+        }
+        // Schedule painting the first instance, starting at the index of the
+        // specified 'task', that is not culled, or finish the instances.
+        void nextInstance( const Task & task )
+        {
+            const DrawingBounds & bounds = instanceBounds.back();
+            const QTransform & toDevice = matrices.back().toDevice;
+            const std::vector< QTransform > & transforms =
+                *task.instances->transforms;
+            const std::vector< QColor > & colors = *task.instances->colors;
+            std::size_t i = task.index;
+            while( i < transforms.size()
+                && deviceCullRect
+                && !deviceRect( bounds, transforms[ i ] * toDevice )
+                        .intersects( *deviceCullRect )
+                 )
+                ++i;
+            if( i == transforms.size() )
+            {
+                instanceBounds.pop_back();
+                return;
+            }
+            Task next( task );
+            next.index = i + 1;
+            tasks.push_back( next );
+            pushMatrices( transforms[ i ] );
+            tasks.push_back( Task( Task::e_POP_MATRICES, 0, 0 ) );
+            // An enclosing recolouring applies to the whole template,
+            // including its own instances.
+            const QColor * const instanceColor =
+                task.color || colors.empty() ? task.color : &colors[ i ];
+            tasks.push_back( Task( Task::e_PAINT, task.d, instanceColor ) );
+        }
+        PainterStateCache state;
+        const QRectF * const deviceCullRect;
+        const QColor * color;
+        std::vector< Task > tasks;
+        std::vector< Matrices > matrices;
+        std::vector< DrawingBounds > instanceBounds;
     };
 
     void draw( const Drawing & d, QPainter & painter )
     {
-        return boost::apply_visitor
-            ( boost::bind
-             ( Draw()
-             , boost::ref( painter )
-             , _1
-             )
-            , d
-            );
+        Draw( painter, 0 ).run( d );
+    }
+
+    void draw
+        ( const Drawing & d
+        , QPainter & painter
+        , const QRectF & exposedRect
+        )
+    {
+        const QTransform toDevice = painter.combinedTransform();
+        QRectF deviceCullRect = toDevice.mapRect( exposedRect );
+        if( painter.hasClipping() )
+            deviceCullRect = deviceCullRect.intersected
+                ( toDevice.mapRect( painter.clipBoundingRect() ) );
+        Draw( painter, &deviceCullRect ).run( d );
     }
 }
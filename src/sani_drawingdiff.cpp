@@ -0,0 +1,253 @@
+#include <sani/drawingdiff.hpp>
+
+#include <QTransform>
+#include <utility>
+
+namespace sani {
+
+namespace {
+// Return 'true' if the specified 'a' and 'b' paint the same thing, and
+// 'false' if they might not. Composite drawings are only compared by the
+// identity of their children.
+bool equal(const DrawPoint& a, const DrawPoint& b) {
+  return a.pen == b.pen && a.p == b.p;
+}
+
+bool equal(const DrawLine& a, const DrawLine& b) {
+  return a.pen == b.pen && a.p1 == b.p1 && a.p2 == b.p2;
+}
+
+bool equal(const DrawRect& a, const DrawRect& b) {
+  return a.pen == b.pen && a.brush == b.brush && a.rect == b.rect;
+}
+
+bool equal(const DrawRoundedRect& a, const DrawRoundedRect& b) {
+  return a.pen == b.pen && a.brush == b.brush && a.rect == b.rect &&
+         a.xRadius == b.xRadius && a.yRadius == b.yRadius &&
+         a.absolute == b.absolute;
+}
+
+bool equal(const DrawText& a, const DrawText& b) {
+  return a.pen == b.pen && a.brush == b.brush && a.font == b.font &&
+         a.position == b.position && a.text == b.text;
+}
+
+bool equal(const DrawEllipse& a, const DrawEllipse& b) {
+  return a.pen == b.pen && a.brush == b.brush && a.rect == b.rect;
+}
+
+bool equal(const DrawArc& a, const DrawArc& b) {
+  return a.pen == b.pen && a.brush == b.brush && a.rect == b.rect &&
+         a.startAngle == b.startAngle && a.spanAngle == b.spanAngle;
+}
+
+bool equal(const DrawPie& a, const DrawPie& b) {
+  return a.pen == b.pen && a.brush == b.brush && a.rect == b.rect &&
+         a.startAngle == b.startAngle && a.spanAngle == b.spanAngle;
+}
+
+bool equal(const DrawChord& a, const DrawChord& b) {
+  return a.pen == b.pen && a.brush == b.brush && a.rect == b.rect &&
+         a.startAngle == b.startAngle && a.spanAngle == b.spanAngle;
+}
+
+bool equal(const DrawCached& a, const DrawCached& b) {
+  return a.hash == b.hash && a.d == b.d;
+}
+
+bool equal(const DrawNothing&, const DrawNothing&) { return true; }
+
+bool equal(const DrawOver& a, const DrawOver& b) {
+  return a.d1 == b.d1 && a.d2 == b.d2;
+}
+
+bool equal(const DrawGroup& a, const DrawGroup& b) {
+  return a.children == b.children;
+}
+
+bool equal(const DrawLOD& a, const DrawLOD& b) {
+  return a.levels == b.levels && a.minScales == b.minScales;
+}
+
+bool equal(const DrawTransform& a, const DrawTransform& b) {
+  return a.t == b.t && a.d == b.d;
+}
+
+bool equal(const DrawInstances& a, const DrawInstances& b) {
+  return a.d == b.d && a.transforms == b.transforms && a.colors == b.colors;
+}
+
+// This class implements a binary visitor that compares two drawings that are
+// not further decomposed.
+struct Equal : boost::static_visitor<bool> {
+  template <typename T, typename U>
+  bool operator()(const T&, const U&) const {
+    return false;
+  }
+
+  template <typename T>
+  bool operator()(const T& a, const T& b) const {
+    return equal(a, b);
+  }
+};
+
+// This class implements a binary visitor that schedules comparing the
+// children of two composite drawing nodes of the same kind with equal
+// attributes and returns 'true', or returns 'false' for any other pair.
+class EnterChildren : public boost::static_visitor<bool> {
+ public:
+  typedef std::pair<const Drawing*, const Drawing*> Children;
+
+  explicit EnterChildren(std::vector<Children>& pending)
+      : m_pending(pending) {}
+
+  template <typename T, typename U>
+  bool operator()(const T&, const U&) const {
+    return false;
+  }
+  bool operator()(const DrawOver& a, const DrawOver& b) const {
+    enter(*a.d1, *b.d1);
+    enter(*a.d2, *b.d2);
+    return true;
+  }
+  bool operator()(const DrawTransform& a, const DrawTransform& b) const {
+    if (a.t != b.t)
+      return false;
+    enter(*a.d, *b.d);
+    return true;
+  }
+  bool operator()(const DrawCached& a, const DrawCached& b) const {
+    if (a.hash != b.hash)
+      return false;
+    enter(*a.d, *b.d);
+    return true;
+  }
+  bool operator()(const DrawInstances& a, const DrawInstances& b) const {
+    if (*a.transforms != *b.transforms || *a.colors != *b.colors)
+      return false;
+    enter(*a.d, *b.d);
+    return true;
+  }
+  bool operator()(const DrawGroup& a, const DrawGroup& b) const {
+    return enter(*a.children, *b.children);
+  }
+  bool operator()(const DrawLOD& a, const DrawLOD& b) const {
+    return *a.minScales == *b.minScales && enter(*a.levels, *b.levels);
+  }
+
+ private:
+  // Schedule comparing the specified 'a' with the specified 'b'.
+  void enter(const Drawing& a, const Drawing& b) const {
+    m_pending.push_back(Children(&a, &b));
+  }
+
+  // Schedule comparing the specified 'a' with the specified 'b' element by
+  // element and return 'true', or return 'false' if their sizes differ.
+  bool enter(const std::vector<Drawing>& a,
+             const std::vector<Drawing>& b) const {
+    if (a.size() != b.size())
+      return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+      enter(a[i], b[i]);
+    return true;
+  }
+
+  std::vector<Children>& m_pending;
+};
+
+// A pair of corresponding subtrees and the transform that maps their
+// coordinates to those of the root drawings.
+struct Pair {
+  Pair(const Drawing* before_, const Drawing* after_, const QTransform& t_)
+      : before(before_), after(after_), t(t_) {}
+
+  const Drawing* before;
+  const Drawing* after;
+  QTransform t;
+};
+
+// Append the bounds of the specified 'd', mapped with the specified 't', to
+// the specified 'result' unless 'd' paints nothing.
+void appendBounds(const Drawing& d,
+                  const QTransform& t,
+                  std::vector<DrawingBounds>& result) {
+  DrawingBounds bounds = drawingBounds(d);
+  if (!bounds.isEmpty) {
+    bounds.rect = t.mapRect(bounds.rect);
+    result.push_back(bounds);
+  }
+}
+}
+
+std::vector<DrawingBounds> changedBounds(const Drawing& before,
+                                         const Drawing& after) {
+  std::vector<DrawingBounds> result;
+  std::vector<Pair> pending(1, Pair(&before, &after, QTransform()));
+  while (!pending.empty()) {
+    const Pair pair = pending.back();
+    pending.pop_back();
+    if (pair.before == pair.after)
+      continue;
+
+    const DrawOver* const overBefore = boost::get<DrawOver>(pair.before);
+    const DrawOver* const overAfter = boost::get<DrawOver>(pair.after);
+    if (overBefore && overAfter) {
+      pending.push_back(
+          Pair(overBefore->d1.get(), overAfter->d1.get(), pair.t));
+      pending.push_back(
+          Pair(overBefore->d2.get(), overAfter->d2.get(), pair.t));
+      continue;
+    }
+
+    const DrawGroup* const groupBefore = boost::get<DrawGroup>(pair.before);
+    const DrawGroup* const groupAfter = boost::get<DrawGroup>(pair.after);
+    if (groupBefore && groupAfter &&
+        groupBefore->children->size() == groupAfter->children->size()) {
+      const std::vector<Drawing>& childrenBefore = *groupBefore->children;
+      const std::vector<Drawing>& childrenAfter = *groupAfter->children;
+      if (&childrenBefore == &childrenAfter)
+        continue;
+      for (std::size_t i = 0; i < childrenBefore.size(); ++i)
+        pending.push_back(Pair(&childrenBefore[i], &childrenAfter[i], pair.t));
+      continue;
+    }
+
+    const DrawTransform* const transformBefore =
+        boost::get<DrawTransform>(pair.before);
+    const DrawTransform* const transformAfter =
+        boost::get<DrawTransform>(pair.after);
+    if (transformBefore && transformAfter &&
+        transformBefore->t == transformAfter->t) {
+      pending.push_back(Pair(transformBefore->d.get(),
+                             transformAfter->d.get(),
+                             transformBefore->t * pair.t));
+      continue;
+    }
+
+    if (!shallowEqual(*pair.before, *pair.after)) {
+      appendBounds(*pair.before, pair.t, result);
+      appendBounds(*pair.after, pair.t, result);
+    }
+  }
+  return result;
+}
+
+bool shallowEqual(const Drawing& a, const Drawing& b) {
+  return boost::apply_visitor(Equal(), a, b);
+}
+
+bool structurallyEqual(const Drawing& a, const Drawing& b) {
+  std::vector<EnterChildren::Children> pending(
+      1, EnterChildren::Children(&a, &b));
+  while (!pending.empty()) {
+    const EnterChildren::Children children = pending.back();
+    pending.pop_back();
+    if (children.first != children.second &&
+        !shallowEqual(*children.first, *children.second) &&
+        !boost::apply_visitor(EnterChildren(pending), *children.first,
+                              *children.second))
+      return false;
+  }
+  return true;
+}
+}
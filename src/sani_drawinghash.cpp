@@ -0,0 +1,308 @@
+#include <sani/drawinghash.hpp>
+
+#include <boost/functional/hash.hpp>
+#include <QHash>
+#include <QImage>
+#include <QLinearGradient>
+#include <vector>
+
+namespace sani {
+
+namespace {
+// Combine the hash of the specified 'value' into the specified 'seed'.
+void combine(std::size_t& seed, const qreal value) {
+  boost::hash_combine(seed, value);
+}
+
+void combine(std::size_t& seed, const int value) {
+  boost::hash_combine(seed, value);
+}
+
+void combine(std::size_t& seed, const QColor& value) {
+  boost::hash_combine(seed, value.rgba());
+}
+
+void combine(std::size_t& seed, const QPointF& value) {
+  combine(seed, value.x());
+  combine(seed, value.y());
+}
+
+void combine(std::size_t& seed, const QRectF& value) {
+  combine(seed, value.topLeft());
+  combine(seed, value.bottomRight());
+}
+
+void combine(std::size_t& seed, const QTransform& value) {
+  combine(seed, value.m11());
+  combine(seed, value.m12());
+  combine(seed, value.m13());
+  combine(seed, value.m21());
+  combine(seed, value.m22());
+  combine(seed, value.m23());
+  combine(seed, value.m31());
+  combine(seed, value.m32());
+  combine(seed, value.m33());
+}
+
+void combine(std::size_t& seed, const QGradient& value) {
+  combine(seed, int(value.type()));
+  combine(seed, int(value.spread()));
+  combine(seed, int(value.coordinateMode()));
+  for (const QGradientStop& stop : value.stops()) {
+    combine(seed, stop.first);
+    combine(seed, stop.second);
+  }
+  switch (value.type()) {
+    case QGradient::LinearGradient: {
+      const QLinearGradient& g = static_cast<const QLinearGradient&>(value);
+      combine(seed, g.start());
+      combine(seed, g.finalStop());
+    } break;
+    case QGradient::RadialGradient: {
+      const QRadialGradient& g = static_cast<const QRadialGradient&>(value);
+      combine(seed, g.center());
+      combine(seed, g.centerRadius());
+      combine(seed, g.focalPoint());
+      combine(seed, g.focalRadius());
+    } break;
+    case QGradient::ConicalGradient: {
+      const QConicalGradient& g = static_cast<const QConicalGradient&>(value);
+      combine(seed, g.center());
+      combine(seed, g.angle());
+    } break;
+    default:
+      break;
+  }
+}
+
+void combine(std::size_t& seed, const QBrush& value) {
+  combine(seed, int(value.style()));
+  if (value.style() == Qt::NoBrush)
+    return;
+  combine(seed, value.color());
+  combine(seed, value.transform());
+  if (const QGradient* const gradient = value.gradient())
+    combine(seed, *gradient);
+  if (value.style() == Qt::TexturePattern)
+    boost::hash_combine(seed, value.textureImage().cacheKey());
+}
+
+void combine(std::size_t& seed, const QPen& value) {
+  combine(seed, int(value.style()));
+  if (value.style() == Qt::NoPen)
+    return;
+  combine(seed, value.widthF());
+  combine(seed, int(value.capStyle()));
+  combine(seed, int(value.joinStyle()));
+  combine(seed, value.miterLimit());
+  combine(seed, int(value.isCosmetic()));
+  if (value.style() == Qt::CustomDashLine) {
+    for (const qreal dash : value.dashPattern())
+      combine(seed, dash);
+    combine(seed, value.dashOffset());
+  }
+  combine(seed, value.brush());
+}
+
+void combine(std::size_t& seed, const QFont& value) {
+  boost::hash_combine(seed, qHash(value.key()));
+}
+
+// This class implements a visitor that combines the hash of the fields of a
+// drawing node into a seed. The hashes of the children of a composite node
+// are read, in order, from a given array.
+class Hash : public boost::static_visitor<> {
+ public:
+  Hash(std::size_t& seed, const std::size_t* children)
+      : m_seed(seed), m_children(children) {}
+
+  void operator()(const DrawPoint& d) const {
+    combine(m_seed, d.pen);
+    combine(m_seed, d.p);
+  }
+  void operator()(const DrawLine& d) const {
+    combine(m_seed, d.pen);
+    combine(m_seed, d.p1);
+    combine(m_seed, d.p2);
+  }
+  void operator()(const DrawRect& d) const {
+    combine(m_seed, d.pen);
+    combine(m_seed, d.brush);
+    combine(m_seed, d.rect);
+  }
+  void operator()(const DrawRoundedRect& d) const {
+    combine(m_seed, d.pen);
+    combine(m_seed, d.brush);
+    combine(m_seed, d.rect);
+    combine(m_seed, d.xRadius);
+    combine(m_seed, d.yRadius);
+    combine(m_seed, int(d.absolute));
+  }
+  void operator()(const DrawText& d) const {
+    combine(m_seed, d.pen);
+    combine(m_seed, d.brush);
+    combine(m_seed, d.font);
+    combine(m_seed, d.position);
+    boost::hash_combine(m_seed, d.text);
+  }
+  void operator()(const DrawEllipse& d) const {
+    combine(m_seed, d.pen);
+    combine(m_seed, d.brush);
+    combine(m_seed, d.rect);
+  }
+  void operator()(const DrawArc& d) const {
+    combine(m_seed, d.pen);
+    combine(m_seed, d.brush);
+    combine(m_seed, d.rect);
+    combine(m_seed, d.startAngle);
+    combine(m_seed, d.spanAngle);
+  }
+  void operator()(const DrawPie& d) const {
+    combine(m_seed, d.pen);
+    combine(m_seed, d.brush);
+    combine(m_seed, d.rect);
+    combine(m_seed, d.startAngle);
+    combine(m_seed, d.spanAngle);
+  }
+  void operator()(const DrawChord& d) const {
+    combine(m_seed, d.pen);
+    combine(m_seed, d.brush);
+    combine(m_seed, d.rect);
+    combine(m_seed, d.startAngle);
+    combine(m_seed, d.spanAngle);
+  }
+  void operator()(const DrawNothing&) const {}
+  void operator()(const DrawOver&) const {
+    boost::hash_combine(m_seed, m_children[0]);
+    boost::hash_combine(m_seed, m_children[1]);
+  }
+  void operator()(const DrawGroup& d) const {
+    boost::hash_combine(m_seed, d.children->size());
+    for (std::size_t i = 0; i < d.children->size(); ++i)
+      boost::hash_combine(m_seed, m_children[i]);
+  }
+  void operator()(const DrawLOD& d) const {
+    boost::hash_combine(m_seed, d.levels->size());
+    for (std::size_t i = 0; i < d.levels->size(); ++i) {
+      boost::hash_combine(m_seed, (*d.minScales)[i]);
+      boost::hash_combine(m_seed, m_children[i]);
+    }
+  }
+  void operator()(const DrawTransform& d) const {
+    combine(m_seed, d.t);
+    boost::hash_combine(m_seed, m_children[0]);
+  }
+  void operator()(const DrawCached& d) const {
+    boost::hash_combine(m_seed, d.hash);
+  }
+  void operator()(const DrawInstances& d) const {
+    boost::hash_combine(m_seed, m_children[0]);
+    boost::hash_combine(m_seed, d.transforms->size());
+    for (const QTransform& t : *d.transforms)
+      combine(m_seed, t);
+    boost::hash_combine(m_seed, d.colors->size());
+    for (const QColor& color : *d.colors)
+      combine(m_seed, color);
+  }
+
+ private:
+  std::size_t& m_seed;
+  const std::size_t* const m_children;
+};
+
+// A unit of pending work of 'hash_value'
+struct Task {
+  Task(const Drawing* d_, bool combine_, std::size_t arity_)
+      : d(d_), combine(combine_), arity(arity_) {}
+
+  const Drawing* d;   // Drawing to hash
+  bool combine;       // If 'true', the hashes of the children of 'd' are on
+                      // top of the value stack and only need to be combined.
+  std::size_t arity;  // Number of children of 'd' if 'combine'
+};
+
+// This class implements a visitor that schedules hashing the children of a
+// composite drawing node followed by combining them, and returns whether it
+// did, i.e. whether the node has children.
+class Enter : public boost::static_visitor<bool> {
+ public:
+  Enter(const Drawing& node, std::vector<Task>& tasks)
+      : m_node(node), m_tasks(tasks) {}
+
+  template <typename T>
+  bool operator()(const T&) const {
+    return false;
+  }
+  bool operator()(const DrawOver& d) const {
+    combine(2);
+    enter(*d.d2);
+    enter(*d.d1);
+    return true;
+  }
+  bool operator()(const DrawTransform& d) const {
+    combine(1);
+    enter(*d.d);
+    return true;
+  }
+  bool operator()(const DrawInstances& d) const {
+    combine(1);
+    enter(*d.d);
+    return true;
+  }
+  bool operator()(const DrawGroup& d) const { return enter(*d.children); }
+  bool operator()(const DrawLOD& d) const { return enter(*d.levels); }
+
+ private:
+  // Schedule combining the specified 'arity' children of the current node.
+  void combine(std::size_t arity) const {
+    m_tasks.push_back(Task(&m_node, true, arity));
+  }
+
+  // Schedule hashing the specified 'd'.
+  void enter(const Drawing& d) const { m_tasks.push_back(Task(&d, false, 0)); }
+
+  // Schedule hashing the specified 'children' of the current node followed by
+  // combining them and return 'true', or return 'false' if there are none.
+  bool enter(const std::vector<Drawing>& children) const {
+    if (children.empty())
+      return false;
+    combine(children.size());
+    for (std::size_t i = children.size(); i > 0; --i)
+      enter(children[i - 1]);
+    return true;
+  }
+
+  const Drawing& m_node;
+  std::vector<Task>& m_tasks;
+};
+
+// Return the hash of the specified 'd' whose children have the hashes in the
+// array starting at the specified 'children'.
+std::size_t hashNode(const Drawing& d, const std::size_t* children) {
+  std::size_t seed = 0;
+  boost::hash_combine(seed, d.which());
+  boost::apply_visitor(Hash(seed, children), d);
+  return seed;
+}
+}
+
+std::size_t hash_value(const Drawing& d) {
+  // When a node is combined, the hashes of its children are on top of
+  // 'values', in order.
+  std::vector<Task> tasks(1, Task(&d, false, 0));
+  std::vector<std::size_t> values;
+  while (!tasks.empty()) {
+    const Task task = tasks.back();
+    tasks.pop_back();
+    if (task.combine) {
+      const std::size_t first = values.size() - task.arity;
+      const std::size_t hash = hashNode(*task.d, &values[first]);
+      values.resize(first);
+      values.push_back(hash);
+    } else if (!boost::apply_visitor(Enter(*task.d, tasks), *task.d)) {
+      values.push_back(hashNode(*task.d, 0));
+    }
+  }
+  return values.back();
+}
+}
@@ -0,0 +1,97 @@
+#include <sani/flattendrawing.hpp>
+
+#include <sani/rewritedrawing.hpp>
+
+namespace sani {
+
+namespace {
+// Append the operands of the tree of 'DrawOver' and 'DrawGroup' nodes rooted
+// at the specified 'root' to the specified 'operands' in painting order.
+void appendTreeOperands(const DrawingNode& root,
+                        std::vector<DrawingRewriter::Operand>& operands) {
+  std::vector<DrawingNode> pending(1, root);
+  while (!pending.empty()) {
+    const DrawingNode node = pending.back();
+    pending.pop_back();
+    if (const DrawOver* const over = boost::get<DrawOver>(node.get())) {
+      pending.push_back(over->d1);
+      pending.push_back(over->d2);
+    } else if (const DrawGroup* const group = boost::get<DrawGroup>(
+                   node.get())) {
+      const std::vector<Drawing>& children = *group->children;
+      for (std::size_t i = children.size(); i > 0; --i)
+        pending.push_back(DrawingNode(group->children, &children[i - 1]));
+    } else {
+      operands.push_back(DrawingRewriter::Operand(node, 0));
+    }
+  }
+}
+
+// This class implements the rules of 'flattenDrawing'.
+class Flattener : public DrawingRewriter {
+ public:
+  void appendOperands(const DrawingNode& node, int,
+                      std::vector<Operand>& operands) override {
+    if (boost::get<DrawOver>(node.get()) || boost::get<DrawGroup>(node.get())) {
+      appendTreeOperands(node, operands);
+    } else if (const DrawTransform* const transform =
+                   boost::get<DrawTransform>(node.get())) {
+      operands.push_back(Operand(transform->d, 0));
+    } else if (const DrawInstances* const instances =
+                   boost::get<DrawInstances>(node.get())) {
+      operands.push_back(Operand(instances->d, 0));
+    } else if (const DrawLOD* const lod = boost::get<DrawLOD>(node.get())) {
+      const std::vector<Drawing>& levels = *lod->levels;
+      for (const Drawing& level : levels)
+        operands.push_back(Operand(DrawingNode(lod->levels, &level), 0));
+    }
+  }
+
+  DrawingNode rebuild(const DrawingNode& node, int, const DrawingNode* first,
+                      std::size_t arity) override {
+    if (const DrawTransform* const transform =
+            boost::get<DrawTransform>(node.get())) {
+      if (*first != transform->d)
+        return std::make_shared<const Drawing>(
+            DrawTransform(transform->t, *first));
+    } else if (const DrawInstances* const instances =
+                   boost::get<DrawInstances>(node.get())) {
+      if (*first != instances->d) {
+        DrawInstances copy(*instances);
+        copy.d = *first;
+        return std::make_shared<const Drawing>(std::move(copy));
+      }
+    } else if (const DrawLOD* const lod = boost::get<DrawLOD>(node.get())) {
+      if (!sameDrawings(*lod->levels, first, arity)) {
+        DrawLOD copy(*lod);
+        copy.levels = std::make_shared<const std::vector<Drawing>>(
+            copyDrawings(first, arity));
+        return std::make_shared<const Drawing>(std::move(copy));
+      }
+    } else if (arity == 1) {
+      return *first;
+    } else if (!isFlat(node, first, arity)) {
+      return std::make_shared<const Drawing>(
+          DrawGroup(copyDrawings(first, arity)));
+    }
+    return node;
+  }
+
+ private:
+  // Return 'true' if the specified 'node' is a leaf or a 'DrawGroup' whose
+  // children are the specified 'arity' flattened operands starting at the
+  // specified 'first', and 'false' otherwise.
+  static bool isFlat(const DrawingNode& node, const DrawingNode* first,
+                     std::size_t arity) {
+    if (const DrawGroup* const group = boost::get<DrawGroup>(node.get()))
+      return sameDrawings(*group->children, first, arity);
+    return !boost::get<DrawOver>(node.get());
+  }
+};
+}
+
+Drawing flattenDrawing(const Drawing& d) {
+  Flattener flattener;
+  return rewriteDrawing(d, flattener);
+}
+}
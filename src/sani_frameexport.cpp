@@ -0,0 +1,201 @@
+#include <sani/frameexport.hpp>
+
+#include <sani/displaylist.hpp>
+#include <sani/drawing.hpp>
+#include <sani/idlehelpers.hpp>
+
+#include <boost/bind.hpp>
+#include <QImage>
+#include <QRect>
+#include <QSvgGenerator>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace sani {
+
+namespace {
+// The state shared by the threads taking part in one export
+class ExportJob {
+ public:
+  ExportJob(const FrameExportSettings& settings,
+            const Animation* animation,
+            const boost::function<Animation()>* makeAnimation)
+      : m_settings(settings),
+        m_animation(animation),
+        m_makeAnimation(makeAnimation),
+        m_frameCount(frameCount(settings)),
+        m_next(0),
+        m_failed(false),
+        m_closed(false) {}
+
+  // Return the number of frames to export.
+  std::size_t frameCount() const { return m_frameCount; }
+
+  // Return 'true' if writing a frame failed, and 'false' otherwise.
+  bool failed() const { return m_failed; }
+
+  // Take part in the export on a thread other than the one that started it.
+  void help() {
+    if (m_makeAnimation)
+      pullAndWrite();
+    else
+      writeQueued();
+  }
+
+  // Pull the frames in order, queue them for the encoders, and write the
+  // rest of the queue once all frames are pulled.
+  void pullInOrder() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (std::size_t i = 0; i < m_frameCount && !m_failed; ++i) {
+      lock.unlock();
+      boost::optional<Drawing> opDrawing = m_animation->pull(frameTime(i));
+      lock.lock();
+      if (!opDrawing)
+        break;
+      // When the queue is full, encode a frame here instead of waiting for
+      // another thread.
+      while (m_queue.size() >= m_settings.maxQueuedFrames)
+        writeFront(lock);
+      m_queue.push_back(std::make_pair(i, std::move(*opDrawing)));
+      m_changed.notify_one();
+    }
+    m_closed = true;
+    m_changed.notify_all();
+    lock.unlock();
+    writeQueued();
+  }
+
+  // Create an animation, and pull and write frames that no other thread
+  // took until there are none left.
+  void pullAndWrite() {
+    const Animation animation = (*m_makeAnimation)();
+    for (;;) {
+      const std::size_t i = m_next++;
+      if (i >= m_frameCount || m_failed)
+        return;
+      const boost::optional<Drawing> opDrawing = animation.pull(frameTime(i));
+      if (!opDrawing) {
+        m_next = m_frameCount;
+        return;
+      }
+      if (!writeFrame(i, *opDrawing))
+        m_failed = true;
+    }
+  }
+
+ private:
+  // Return the number of frames described by the specified 'settings'.
+  static std::size_t frameCount(const FrameExportSettings& settings) {
+    const double span =
+        (settings.endTime - settings.startTime) * settings.frameRate;
+    return span > 0.0 ? std::size_t(std::ceil(span)) : 0;
+  }
+
+  // Return the time of the frame with the specified 'index'.
+  double frameTime(std::size_t index) const {
+    return m_settings.startTime + index / m_settings.frameRate;
+  }
+
+  // Write queued frames until the queue is empty and no more frames will be
+  // queued.
+  void writeQueued() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+      while (m_queue.empty() && !m_closed)
+        m_changed.wait(lock);
+      if (m_queue.empty())
+        return;
+      writeFront(lock);
+    }
+  }
+
+  // Remove the first queued frame and write it, releasing the specified
+  // 'lock' on 'm_mutex' meanwhile.
+  void writeFront(std::unique_lock<std::mutex>& lock) {
+    const std::pair<std::size_t, Drawing> frame = std::move(m_queue.front());
+    m_queue.pop_front();
+    lock.unlock();
+    if (!m_failed && !writeFrame(frame.first, frame.second))
+      m_failed = true;
+    lock.lock();
+  }
+
+  // Render the specified 'd', the frame with the specified 'index', and
+  // write it to its file. Return 'true' on success, and 'false' otherwise.
+  bool writeFrame(std::size_t index, const Drawing& d) const {
+    const QString fileName = m_settings.fileNamePattern.arg(
+        qulonglong(index), m_settings.indexDigits, 10, QChar('0'));
+    if (m_settings.format == FrameExportSettings::e_SVG) {
+      QSvgGenerator generator;
+      generator.setFileName(fileName);
+      generator.setSize(m_settings.size);
+      generator.setViewBox(QRect(QPoint(0, 0), m_settings.size));
+      QPainter painter;
+      if (!painter.begin(&generator))
+        return false;
+      painter.fillRect(QRect(QPoint(0, 0), m_settings.size),
+                       m_settings.background);
+      paintFrame(d, painter);
+      return painter.end();
+    }
+    // The image starts uninitialized, so a translucent background must
+    // replace its contents rather than be blended onto them.
+    QImage image(m_settings.size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(m_settings.background);
+    QPainter painter(&image);
+    paintFrame(d, painter);
+    painter.end();
+    return image.save(fileName, "PNG");
+  }
+
+  // Paint the specified 'd' using the specified 'painter', whose device
+  // already shows the background.
+  void paintFrame(const Drawing& d, QPainter& painter) const {
+    painter.setRenderHints(m_settings.renderHints);
+    painter.setTransform(m_settings.transform);
+    drawBatched(compile(d, m_settings.transform), painter);
+  }
+
+  const FrameExportSettings& m_settings;
+  const Animation* const m_animation;  // Pulled in order if set
+  const boost::function<Animation()>* const m_makeAnimation;
+  const std::size_t m_frameCount;
+  std::atomic<std::size_t> m_next;  // Index of the next frame to pull in
+                                    // parallel
+  std::atomic<bool> m_failed;
+  std::mutex m_mutex;
+  std::condition_variable m_changed;  // Signals a change of 'm_queue' or
+                                      // 'm_closed'
+  std::deque<std::pair<std::size_t, Drawing>> m_queue;  // Frames to write
+  bool m_closed;  // 'true' once no more frames will be queued
+};
+
+// Run the specified 'job' on the calling thread and on as many idle threads
+// of the global thread pool as useful. Return 'true' if all frames were
+// written, and 'false' otherwise.
+bool run(ExportJob& job, bool pullInOrder) {
+  const std::size_t frameCount = job.frameCount();
+  runWithIdleHelpers(
+      frameCount > 0 ? frameCount - 1 : 0, boost::bind(&ExportJob::help, &job),
+      pullInOrder ? boost::bind(&ExportJob::pullInOrder, &job)
+                  : boost::bind(&ExportJob::pullAndWrite, &job));
+  return !job.failed();
+}
+}
+
+bool exportFrames(const Animation& animation,
+                  const FrameExportSettings& settings) {
+  ExportJob job(settings, &animation, 0);
+  return run(job, true);
+}
+
+bool exportIndependentFrames(const boost::function<Animation()>& makeAnimation,
+                             const FrameExportSettings& settings) {
+  ExportJob job(settings, 0, &makeAnimation);
+  return run(job, false);
+}
+}
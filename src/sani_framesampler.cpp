@@ -0,0 +1,81 @@
+#include <sani/framesampler.hpp>
+
+#include <sani/optimizedrawing.hpp>
+
+#include <QElapsedTimer>
+#include <utility>
+
+namespace sani {
+
+FrameSampler::FrameSampler(const Animation& animation)
+    : m_animation(animation),
+      m_optimize(false),
+      m_stop(false),
+      m_thread(&FrameSampler::run, this) {}
+
+FrameSampler::~FrameSampler() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_one();
+  m_thread.join();
+}
+
+void FrameSampler::requestFrame(double time) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_opRequestedTime = time;
+  }
+  m_wake.notify_one();
+}
+
+void FrameSampler::post(const boost::function<void()>& input) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_inputs.push_back(input);
+}
+
+void FrameSampler::setOptimization(bool enabled) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_optimize = enabled;
+}
+
+boost::optional<FrameSampler::Frame> FrameSampler::takeFrame() {
+  if (!m_frames.update())
+    return boost::none;
+  return std::move(m_frames.front());
+}
+
+void FrameSampler::run() {
+  std::vector<boost::function<void()> > inputs;
+  for (;;) {
+    double time;
+    bool optimize;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (!m_stop && !m_opRequestedTime)
+        m_wake.wait(lock);
+      if (m_stop)
+        return;
+      time = *m_opRequestedTime;
+      m_opRequestedTime = boost::none;
+      optimize = m_optimize;
+      inputs.swap(m_inputs);
+    }
+
+    for (const boost::function<void()>& input : inputs)
+      input();
+    inputs.clear();
+
+    Frame& frame = m_frames.back();
+    QElapsedTimer pullTimer;
+    pullTimer.start();
+    frame.opDrawing = m_animation.pull(time);
+    if (optimize && frame.opDrawing)
+      frame.opDrawing = optimizeDrawing(*frame.opDrawing);
+    frame.pullNsecs = pullTimer.nsecsElapsed();
+    frame.time = time;
+    m_frames.publish();
+  }
+}
+}
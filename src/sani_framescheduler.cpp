@@ -0,0 +1,86 @@
+#include <sani/framescheduler.hpp>
+
+#include <QGuiApplication>
+#include <QScreen>
+#include <QTimerEvent>
+
+namespace sani {
+
+namespace {
+// The rate used when the refresh rate of the screen is unknown
+const double fallbackRateHz = 60.0;
+
+// Return the rate selected by the specified 'rateHz'.
+double effectiveRate(double rateHz) {
+  if (rateHz > 0.0)
+    return rateHz;
+  const QScreen* const screen = QGuiApplication::primaryScreen();
+  if (screen && screen->refreshRate() > 0.0)
+    return screen->refreshRate();
+  return fallbackRateHz;
+}
+}
+
+FrameScheduler::~FrameScheduler() {}
+
+TimerFrameScheduler::TimerFrameScheduler(double rateHz)
+    : m_intervalNsecs(qint64(1e9 / effectiveRate(rateHz))),
+      m_nextDeadlineNsecs(0),
+      m_missedFrames(0),
+      m_active(false) {}
+
+void TimerFrameScheduler::setRate(double rateHz) {
+  m_intervalNsecs = qint64(1e9 / effectiveRate(rateHz));
+  if (m_active) {
+    stop();
+    start();
+  }
+}
+
+double TimerFrameScheduler::rate() const { return 1e9 / m_intervalNsecs; }
+
+void TimerFrameScheduler::start() {
+  if (m_active)
+    return;
+  m_active = true;
+  m_clock.start();
+  m_nextDeadlineNsecs = 0;
+  m_missedFrames = 0;
+  m_timer.start(0, Qt::PreciseTimer, this);
+}
+
+void TimerFrameScheduler::stop() {
+  m_active = false;
+  m_timer.stop();
+}
+
+bool TimerFrameScheduler::isActive() const { return m_active; }
+
+qint64 TimerFrameScheduler::intervalNsecs() const { return m_intervalNsecs; }
+
+void TimerFrameScheduler::timerEvent(QTimerEvent* event) {
+  if (event->timerId() != m_timer.timerId()) {
+    FrameScheduler::timerEvent(event);
+    return;
+  }
+  m_timer.stop();
+  m_nextDeadlineNsecs += m_intervalNsecs;
+  const int missedFrames = m_missedFrames;
+  m_missedFrames = 0;
+  Q_EMIT frameDue(missedFrames);
+  if (m_active)
+    scheduleNextTick();
+}
+
+void TimerFrameScheduler::scheduleNextTick() {
+  const qint64 now = m_clock.nsecsElapsed();
+  if (now >= m_nextDeadlineNsecs) {
+    const qint64 skipped = (now - m_nextDeadlineNsecs) / m_intervalNsecs + 1;
+    m_missedFrames += int(skipped);
+    m_nextDeadlineNsecs += skipped * m_intervalNsecs;
+  }
+  const qint64 remainingNsecs = m_nextDeadlineNsecs - now;
+  m_timer.start(int((remainingNsecs + 999999) / 1000000), Qt::PreciseTimer,
+                this);
+}
+}
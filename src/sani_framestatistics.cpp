@@ -0,0 +1,95 @@
+#include <sani/framestatistics.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace sani {
+
+namespace {
+const std::size_t defaultWindowSize = 240;
+const qint64 defaultBinWidthNsecs = 1000000;
+const std::size_t defaultBinCount = 64;
+}
+
+RollingHistogram::RollingHistogram(std::size_t windowSize,
+                                   qint64 binWidthNsecs,
+                                   std::size_t binCount)
+    : m_window(windowSize),
+      m_next(0),
+      m_size(0),
+      m_sum(0),
+      m_bins(binCount),
+      m_binWidthNsecs(binWidthNsecs) {}
+
+void RollingHistogram::add(qint64 nsecs) {
+  if (m_size == m_window.size()) {
+    const qint64 oldest = m_window[m_next];
+    --m_bins[binOf(oldest)];
+    m_sum -= oldest;
+  } else {
+    ++m_size;
+  }
+  m_window[m_next] = nsecs;
+  m_next = (m_next + 1) % m_window.size();
+  ++m_bins[binOf(nsecs)];
+  m_sum += nsecs;
+}
+
+void RollingHistogram::clear() {
+  m_next = 0;
+  m_size = 0;
+  m_sum = 0;
+  std::fill(m_bins.begin(), m_bins.end(), 0);
+}
+
+qint64 RollingHistogram::quantile(double q) const {
+  if (m_size == 0)
+    return 0;
+  std::vector<qint64> sorted(m_window.begin(), m_window.begin() + m_size);
+  const std::size_t rank = std::min(
+      m_size - 1,
+      std::size_t(std::max(0.0, std::ceil(q * m_size) - 1.0)));
+  std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+  return sorted[rank];
+}
+
+qint64 RollingHistogram::mean() const {
+  return m_size == 0 ? 0 : m_sum / qint64(m_size);
+}
+
+std::size_t RollingHistogram::binOf(qint64 nsecs) const {
+  return std::min(m_bins.size() - 1,
+                  std::size_t(std::max<qint64>(0, nsecs / m_binWidthNsecs)));
+}
+
+FrameStatistics::FrameStatistics(qint64 budgetNsecs)
+    : m_budgetNsecs(budgetNsecs),
+      m_pullTimes(defaultWindowSize, defaultBinWidthNsecs, defaultBinCount),
+      m_paintTimes(defaultWindowSize, defaultBinWidthNsecs, defaultBinCount),
+      m_intervals(defaultWindowSize, defaultBinWidthNsecs, defaultBinCount),
+      m_frames(0),
+      m_overBudgetFrames(0),
+      m_lateFrames(0) {}
+
+void FrameStatistics::addFrame(const FrameTiming& timing,
+                               qint64 intervalNsecs) {
+  m_pullTimes.add(timing.pullNsecs);
+  m_paintTimes.add(timing.paintNsecs);
+  if (intervalNsecs > 0)
+    m_intervals.add(intervalNsecs);
+  ++m_frames;
+  if (timing.pullNsecs + timing.paintNsecs > m_budgetNsecs)
+    ++m_overBudgetFrames;
+  if (intervalNsecs > m_budgetNsecs + m_budgetNsecs / 2)
+    ++m_lateFrames;
+}
+
+void FrameStatistics::reset() {
+  m_pullTimes.clear();
+  m_paintTimes.clear();
+  m_intervals.clear();
+  m_frames = 0;
+  m_overBudgetFrames = 0;
+  m_lateFrames = 0;
+}
+}
@@ -0,0 +1,501 @@
+#include <sani/glrenderer.hpp>
+
+#include <boost/variant.hpp>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QPaintDevice>
+#include <QPaintEngine>
+#include <QPainter>
+#include <QVector2D>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace sani {
+
+namespace {
+const qreal pi = 3.14159265358979323846;
+
+// The length, in device pixels, of the chords that approximate curves
+const qreal chordLength = 3.0;
+
+const char* const vertexShaderSource =
+    "attribute highp vec2 position;\n"
+    "attribute lowp vec4 color;\n"
+    "uniform highp vec2 viewportSize;\n"
+    "varying lowp vec4 fragmentColor;\n"
+    "void main() {\n"
+    "  fragmentColor = color;\n"
+    "  gl_Position = vec4(2.0 * position.x / viewportSize.x - 1.0,\n"
+    "                     1.0 - 2.0 * position.y / viewportSize.y,\n"
+    "                     0.0, 1.0);\n"
+    "}\n";
+
+const char* const fragmentShaderSource =
+    "varying lowp vec4 fragmentColor;\n"
+    "void main() {\n"
+    "  gl_FragColor = fragmentColor;\n"
+    "}\n";
+
+// A vertex in device coordinates with a premultiplied color
+struct Vertex {
+  GLfloat x;
+  GLfloat y;
+  GLubyte color[4];
+};
+
+// A premultiplied color as stored in 'Vertex'
+struct Color {
+  explicit Color(const QColor& c) {
+    const int alpha = c.alpha();
+    rgba[0] = GLubyte(c.red() * alpha / 255);
+    rgba[1] = GLubyte(c.green() * alpha / 255);
+    rgba[2] = GLubyte(c.blue() * alpha / 255);
+    rgba[3] = GLubyte(alpha);
+  }
+
+  GLubyte rgba[4];
+};
+
+// Return 'true' if the specified 'brush' can be tessellated.
+bool supported(const QBrush& brush) {
+  return brush.style() == Qt::NoBrush || brush.style() == Qt::SolidPattern;
+}
+
+// Return 'true' if the specified 'pen' can be tessellated. See the component
+// documentation for why strokes must be opaque.
+bool supported(const QPen& pen) {
+  return pen.style() == Qt::NoPen ||
+         (pen.style() == Qt::SolidLine &&
+          pen.brush().style() == Qt::SolidPattern &&
+          pen.color().alpha() == 255);
+}
+
+// Return the specified 'p' rotated by 90 degrees and scaled to the specified
+// 'length', or a null point if 'p' is null.
+QPointF normal(const QPointF& p, qreal length) {
+  const qreal norm = std::sqrt(p.x() * p.x() + p.y() * p.y());
+  if (norm == 0.0)
+    return QPointF();
+  return QPointF(-p.y(), p.x()) * (length / norm);
+}
+
+// Return the number of chords that approximate the outline of an ellipse
+// inscribed in the specified 'rect' when mapped with the specified 't'.
+int chordCount(const QRectF& rect, const QTransform& t) {
+  const QRectF deviceRect = t.mapRect(rect);
+  const qreal circumference =
+      pi * (deviceRect.width() + deviceRect.height()) / 2.0;
+  return std::min(256, std::max(12, int(std::ceil(circumference /
+                                                  chordLength))));
+}
+
+// This class implements the conversion of primitives into triangles.
+class Tessellator {
+ public:
+  // Create a 'Tessellator' object that appends triangles to the specified
+  // 'vertices'.
+  explicit Tessellator(std::vector<Vertex>& vertices) : m_vertices(vertices) {}
+
+  // Append the triangles of the convex polygon with the specified 'points',
+  // given in the coordinates mapped by the specified 't', filled with the
+  // specified 'brush'.
+  void fill(const std::vector<QPointF>& points,
+            const QTransform& t,
+            const QBrush& brush) {
+    if (brush.style() == Qt::NoBrush || points.size() < 3)
+      return;
+    const Color color(brush.color());
+    const QPointF first = t.map(points[0]);
+    QPointF previous = t.map(points[1]);
+    for (std::size_t i = 2; i < points.size(); ++i) {
+      const QPointF current = t.map(points[i]);
+      triangle(first, previous, current, color);
+      previous = current;
+    }
+  }
+
+  // Append the triangles of the stroke with the specified 'pen' of the
+  // polyline with the specified 'points', given in the coordinates mapped by
+  // the specified 't', which is closed if the specified 'closed' is 'true'.
+  void stroke(const std::vector<QPointF>& points,
+              bool closed,
+              const QTransform& t,
+              const QPen& pen) {
+    if (pen.style() == Qt::NoPen || points.empty())
+      return;
+
+    // Cosmetic pens have a width in device pixels and are therefore extruded
+    // after mapping; other pens are extruded before mapping.
+    const bool cosmetic = pen.isCosmetic();
+    m_output = cosmetic ? QTransform() : t;
+    std::vector<QPointF> outline(points);
+    if (cosmetic)
+      for (QPointF& p : outline)
+        p = t.map(p);
+    const qreal halfWidth =
+        (cosmetic ? std::max(pen.widthF(), qreal(1.0)) : pen.widthF()) / 2.0;
+    const Color color(pen.color());
+
+    const std::size_t n = outline.size();
+    const std::size_t segments = closed ? n : n - 1;
+    if (segments == 0 || (n == 2 && outline[0] == outline[1])) {
+      // A point, or a line of length zero which only shows its caps
+      if (segments == 0 || pen.capStyle() != Qt::FlatCap)
+        cap(outline[0], QPointF(1.0, 0.0), halfWidth, pen.capStyle(), color,
+            true);
+      return;
+    }
+
+    for (std::size_t i = 0; i < segments; ++i) {
+      QPointF a = outline[i];
+      QPointF b = outline[(i + 1) % n];
+      const QPointF offset = normal(b - a, halfWidth);
+      if (offset.isNull())
+        continue;
+      if (!closed && pen.capStyle() == Qt::SquareCap) {
+        const QPointF extension(offset.y(), -offset.x());
+        if (i == 0)
+          a -= extension;
+        if (i + 1 == segments)
+          b += extension;
+      }
+      quad(a + offset, b + offset, b - offset, a - offset, color);
+    }
+
+    const std::size_t firstJoint = closed ? 0 : 1;
+    const std::size_t lastJoint = closed ? n : n - 1;
+    for (std::size_t i = firstJoint; i < lastJoint; ++i)
+      join(outline[(i + n - 1) % n], outline[i], outline[(i + 1) % n],
+           halfWidth, pen, color);
+
+    if (!closed && pen.capStyle() == Qt::RoundCap) {
+      cap(outline[0], outline[0] - outline[1], halfWidth, Qt::RoundCap,
+          color, false);
+      cap(outline[n - 1], outline[n - 1] - outline[n - 2], halfWidth,
+          Qt::RoundCap, color, false);
+    }
+  }
+
+ private:
+  // Append the join of the specified 'pen' between the segments from the
+  // specified 'previous' to 'vertex' and from 'vertex' to 'next'.
+  void join(const QPointF& previous,
+            const QPointF& vertex,
+            const QPointF& next,
+            qreal halfWidth,
+            const QPen& pen,
+            const Color& color) {
+    const QPointF before = normal(vertex - previous, halfWidth);
+    const QPointF after = normal(next - vertex, halfWidth);
+    if (before.isNull() || after.isNull())
+      return;
+    for (int side = -1; side <= 1; side += 2) {
+      const QPointF p1 = vertex + side * before;
+      const QPointF p2 = vertex + side * after;
+      if (pen.joinStyle() == Qt::RoundJoin) {
+        fan(vertex, p1, p2, halfWidth, color);
+        continue;
+      }
+      const QPointF bisector = before + after;
+      const qreal bisectorLength =
+          std::sqrt(bisector.x() * bisector.x() + bisector.y() * bisector.y());
+      const bool miter = pen.joinStyle() == Qt::MiterJoin ||
+                         pen.joinStyle() == Qt::SvgMiterJoin;
+      if (miter && bisectorLength > 0.0) {
+        // The distance from 'vertex' to the miter tip, in half widths
+        const qreal miterRatio = 2.0 * halfWidth / bisectorLength;
+        if (miterRatio <= pen.miterLimit()) {
+          const QPointF tip =
+              vertex +
+              side * bisector * (miterRatio * halfWidth / bisectorLength);
+          triangle(m_output.map(vertex), m_output.map(p1), m_output.map(tip),
+                   color);
+          triangle(m_output.map(vertex), m_output.map(tip), m_output.map(p2),
+                   color);
+          continue;
+        }
+      }
+      triangle(m_output.map(vertex), m_output.map(p1), m_output.map(p2),
+               color);
+    }
+  }
+
+  // Append the cap of the specified 'style' at the specified 'end' of a
+  // stroke that leaves it in the specified 'direction'. Draw a whole dot if
+  // the specified 'dot' is 'true'.
+  void cap(const QPointF& end,
+           const QPointF& direction,
+           qreal halfWidth,
+           Qt::PenCapStyle style,
+           const Color& color,
+           bool dot) {
+    const QPointF side = normal(direction, halfWidth);
+    if (side.isNull())
+      return;
+    if (style == Qt::RoundCap) {
+      const QPointF tip(side.y(), -side.x());
+      fan(end, end + side, end + tip, halfWidth, color);
+      fan(end, end + tip, end - side, halfWidth, color);
+      if (dot) {
+        fan(end, end - side, end - tip, halfWidth, color);
+        fan(end, end - tip, end + side, halfWidth, color);
+      }
+    } else if (dot) {
+      const QPointF along(side.y(), -side.x());
+      quad(end + side + along, end + side - along, end - side - along,
+           end - side + along, color);
+    }
+  }
+
+  // Append a circular fan around the specified 'center' from the specified
+  // 'from' to 'to', the shorter way round.
+  void fan(const QPointF& center,
+           const QPointF& from,
+           const QPointF& to,
+           qreal radius,
+           const Color& color) {
+    const qreal a0 = std::atan2(from.y() - center.y(), from.x() - center.x());
+    qreal span = std::atan2(to.y() - center.y(), to.x() - center.x()) - a0;
+    if (span > pi)
+      span -= 2.0 * pi;
+    if (span < -pi)
+      span += 2.0 * pi;
+    const qreal deviceRadius =
+        radius * std::sqrt(std::abs(m_output.determinant()));
+    const int steps =
+        std::max(1, int(std::ceil(std::abs(span) * deviceRadius /
+                                  chordLength)));
+    const QPointF c = m_output.map(center);
+    QPointF previous = m_output.map(from);
+    for (int i = 1; i <= steps; ++i) {
+      const qreal a = a0 + span * i / steps;
+      const QPointF current = m_output.map(
+          center + QPointF(std::cos(a), std::sin(a)) * radius);
+      triangle(c, previous, current, color);
+      previous = current;
+    }
+  }
+
+  // Append the quadrilateral with the specified corners, in stroke
+  // coordinates.
+  void quad(const QPointF& a,
+            const QPointF& b,
+            const QPointF& c,
+            const QPointF& d,
+            const Color& color) {
+    const QPointF ma = m_output.map(a);
+    const QPointF mc = m_output.map(c);
+    triangle(ma, m_output.map(b), mc, color);
+    triangle(ma, mc, m_output.map(d), color);
+  }
+
+  // Append the triangle with the specified device coordinate corners.
+  void triangle(const QPointF& a,
+                const QPointF& b,
+                const QPointF& c,
+                const Color& color) {
+    vertex(a, color);
+    vertex(b, color);
+    vertex(c, color);
+  }
+
+  void vertex(const QPointF& p, const Color& color) {
+    Vertex v;
+    v.x = GLfloat(p.x());
+    v.y = GLfloat(p.y());
+    std::copy(color.rgba, color.rgba + 4, v.color);
+    m_vertices.push_back(v);
+  }
+
+  std::vector<Vertex>& m_vertices;
+  QTransform m_output;  // Maps stroke coordinates to device coordinates
+};
+
+// Return the points of the outline of the specified 'rect'.
+std::vector<QPointF> rectOutline(const QRectF& rect) {
+  std::vector<QPointF> result;
+  result.push_back(rect.topLeft());
+  result.push_back(rect.topRight());
+  result.push_back(rect.bottomRight());
+  result.push_back(rect.bottomLeft());
+  return result;
+}
+
+// Return the points of the outline of the ellipse inscribed in the specified
+// 'rect' when mapped with the specified 't'.
+std::vector<QPointF> ellipseOutline(const QRectF& rect, const QTransform& t) {
+  const int n = chordCount(rect, t);
+  const QPointF center = rect.center();
+  const qreal rx = rect.width() / 2.0;
+  const qreal ry = rect.height() / 2.0;
+  std::vector<QPointF> result;
+  result.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    const qreal a = 2.0 * pi * i / n;
+    result.push_back(center + QPointF(rx * std::cos(a), ry * std::sin(a)));
+  }
+  return result;
+}
+
+// This class implements a visitor that tessellates the primitives that are
+// supported and returns whether it did.
+struct Tessellate : boost::static_visitor<bool> {
+  Tessellate(Tessellator& tessellator, const QTransform& t)
+      : m_tessellator(tessellator), m_t(t) {}
+
+  template <typename T>
+  bool operator()(const T&) const {
+    return false;
+  }
+
+  bool operator()(const DrawPoint& d) const {
+    if (!supported(d.pen) || d.pen.style() == Qt::NoPen)
+      return false;
+    m_tessellator.stroke(std::vector<QPointF>(1, d.p), false, m_t, d.pen);
+    return true;
+  }
+
+  bool operator()(const DrawLine& d) const {
+    if (!supported(d.pen))
+      return false;
+    std::vector<QPointF> points;
+    points.push_back(d.p1);
+    points.push_back(d.p2);
+    m_tessellator.stroke(points, false, m_t, d.pen);
+    return true;
+  }
+
+  bool operator()(const DrawRect& d) const {
+    if (!supported(d.pen) || !supported(d.brush))
+      return false;
+    const std::vector<QPointF> outline = rectOutline(d.rect.normalized());
+    m_tessellator.fill(outline, m_t, d.brush);
+    m_tessellator.stroke(outline, true, m_t, d.pen);
+    return true;
+  }
+
+  bool operator()(const DrawEllipse& d) const {
+    if (!supported(d.pen) || !supported(d.brush))
+      return false;
+    const std::vector<QPointF> outline = ellipseOutline(d.rect, m_t);
+    m_tessellator.fill(outline, m_t, d.brush);
+    m_tessellator.stroke(outline, true, m_t, d.pen);
+    return true;
+  }
+
+  Tessellator& m_tessellator;
+  const QTransform& m_t;
+};
+}
+
+struct GlRenderer::Impl {
+  Impl() : m_buffer(QOpenGLBuffer::VertexBuffer), m_failed(false) {}
+
+  // Draw and clear the vertices accumulated so far using the specified
+  // 'painter'.
+  void flush(QPainter& painter);
+
+  // Create the shader program and vertex buffer if required, and return
+  // 'true' on success.
+  bool initialize();
+
+  std::vector<Vertex> m_vertices;
+  std::unique_ptr<QOpenGLShaderProgram> m_program;
+  QOpenGLBuffer m_buffer;
+  bool m_failed;  // 'true' if 'initialize' failed
+};
+
+bool GlRenderer::Impl::initialize() {
+  if (m_program)
+    return true;
+  if (m_failed)
+    return false;
+  std::unique_ptr<QOpenGLShaderProgram> program(new QOpenGLShaderProgram());
+  program->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShaderSource);
+  program->addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                   fragmentShaderSource);
+  program->bindAttributeLocation("position", 0);
+  program->bindAttributeLocation("color", 1);
+  if (!program->link() || !m_buffer.create()) {
+    m_failed = true;
+    return false;
+  }
+  m_buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+  m_program = std::move(program);
+  return true;
+}
+
+void GlRenderer::Impl::flush(QPainter& painter) {
+  if (m_vertices.empty())
+    return;
+
+  const QPaintDevice* const device = painter.device();
+  painter.beginNativePainting();
+  if (initialize()) {
+    QOpenGLFunctions* const gl = QOpenGLContext::currentContext()->functions();
+    gl->glEnable(GL_BLEND);
+    gl->glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    gl->glDisable(GL_DEPTH_TEST);
+
+    m_program->bind();
+    m_program->setUniformValue(
+        "viewportSize", QVector2D(device->width(), device->height()));
+    m_buffer.bind();
+    m_buffer.allocate(m_vertices.data(),
+                      int(m_vertices.size() * sizeof(Vertex)));
+    m_program->enableAttributeArray(0);
+    m_program->enableAttributeArray(1);
+    m_program->setAttributeBuffer(0, GL_FLOAT, offsetof(Vertex, x), 2,
+                                  sizeof(Vertex));
+    m_program->setAttributeBuffer(1, GL_UNSIGNED_BYTE, offsetof(Vertex, color),
+                                  4, sizeof(Vertex));
+    gl->glDrawArrays(GL_TRIANGLES, 0, GLsizei(m_vertices.size()));
+    m_program->disableAttributeArray(0);
+    m_program->disableAttributeArray(1);
+    m_buffer.release();
+    m_program->release();
+  }
+  painter.endNativePainting();
+  m_vertices.clear();
+}
+
+GlRenderer::GlRenderer() : m_impl(new Impl()) {}
+
+GlRenderer::~GlRenderer() {}
+
+void GlRenderer::draw(const DisplayList& displayList, QPainter& painter) {
+  const QTransform baseWorld = painter.worldTransform();
+  const QTransform baseDevice = painter.combinedTransform();
+  Tessellator tessellator(m_impl->m_vertices);
+
+  std::size_t currentTransformIndex = 0;
+  QTransform toDevice = baseDevice;
+  for (const DisplayList::Command& command : displayList.commands) {
+    if (command.transformIndex != currentTransformIndex) {
+      currentTransformIndex = command.transformIndex;
+      toDevice = displayList.transforms[currentTransformIndex] * baseDevice;
+    }
+    if (toDevice.type() != QTransform::TxProject &&
+        boost::apply_visitor(Tessellate(tessellator, toDevice),
+                             command.primitive))
+      continue;
+
+    m_impl->flush(painter);
+    painter.setWorldTransform(displayList.transforms[currentTransformIndex] *
+                              baseWorld);
+    paintPrimitive(command.primitive, painter);
+  }
+  m_impl->flush(painter);
+  painter.setWorldTransform(baseWorld);
+}
+
+bool isOpenGLPainter(const QPainter& painter) {
+  const QPaintEngine* const engine = painter.paintEngine();
+  return engine && (engine->type() == QPaintEngine::OpenGL2 ||
+                    engine->type() == QPaintEngine::OpenGL);
+}
+}
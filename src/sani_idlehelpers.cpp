@@ -0,0 +1,46 @@
+#include <sani/idlehelpers.hpp>
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <memory>
+
+namespace sani {
+
+namespace {
+// This class implements a thread pool task that runs the help of a
+// 'runWithIdleHelpers' call and signals when it is done.
+class Helper : public QRunnable {
+ public:
+  Helper(const boost::function<void()>& help, QSemaphore& done)
+      : m_help(help), m_done(done) {}
+
+  void run() override {
+    m_help();
+    m_done.release();
+  }
+
+ private:
+  const boost::function<void()>& m_help;
+  QSemaphore& m_done;
+};
+}
+
+void runWithIdleHelpers(std::size_t maxHelpers,
+                        const boost::function<void()>& help,
+                        const boost::function<void()>& work) {
+  QThreadPool* const pool = QThreadPool::globalInstance();
+  QSemaphore done;
+  int helpers = 0;
+  while (std::size_t(helpers) < maxHelpers) {
+    // The pool only takes ownership of a task it starts.
+    std::unique_ptr<Helper> helper(new Helper(help, done));
+    if (!pool->tryStart(helper.get()))
+      break;
+    helper.release();
+    ++helpers;
+  }
+  work();
+  done.acquire(helpers);
+}
+}
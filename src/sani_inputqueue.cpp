@@ -0,0 +1,22 @@
+#include <sani/inputqueue.hpp>
+
+namespace sani {
+
+InputQueue::InputQueue() {}
+
+void InputQueue::push(const InputEvent& event) {
+  if (event.type == InputEvent::e_MOUSE_MOVE && !m_events.empty() &&
+      m_events.back().type == InputEvent::e_MOUSE_MOVE)
+    m_events.back() = event;
+  else
+    m_events.push_back(event);
+}
+
+std::vector<InputEvent> InputQueue::take() {
+  std::vector<InputEvent> result;
+  result.swap(m_events);
+  return result;
+}
+
+bool InputQueue::empty() const { return m_events.empty(); }
+}
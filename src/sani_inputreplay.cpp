@@ -0,0 +1,97 @@
+#include <sani/inputreplay.hpp>
+
+#include <sani/inputqueue.hpp>
+#include <sani/inputtriggers.hpp>
+
+#include <istream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace sani {
+
+namespace {
+
+// This class implements the state of an animation replaying a script of
+// input events.
+struct Replay {
+  // Deliver the events of the script up to the specified 'time' and return
+  // the frame of the animation at 'time'.
+  boost::optional<Drawing> pull(double time) {
+    InputQueue queue;
+    for (; next < script.size() && script[next].time <= time; ++next)
+      queue.push(script[next]);
+    if (!queue.empty())
+      triggers(queue.take());
+    return animation.pull(time);
+  }
+
+  InputTriggers triggers;
+  Animation animation;
+  std::vector<InputEvent> script;
+  std::size_t next;  // Index in 'script' of the first undelivered event
+};
+
+// Load into the specified 'type' the event type with the specified 'name'.
+// Return 'true' on success, and 'false' if there is no such type.
+bool typeFromName(const std::string& name, InputEvent::Type* type) {
+  static const std::pair<const char*, InputEvent::Type> k_TYPES[] = {
+      {"move", InputEvent::e_MOUSE_MOVE},
+      {"press", InputEvent::e_MOUSE_PRESS},
+      {"release", InputEvent::e_MOUSE_RELEASE},
+      {"keypress", InputEvent::e_KEY_PRESS},
+      {"keyrelease", InputEvent::e_KEY_RELEASE}};
+  for (const auto& entry : k_TYPES) {
+    if (name == entry.first) {
+      *type = entry.second;
+      return true;
+    }
+  }
+  return false;
+}
+}
+
+Animation replayInput(const InteractiveAnimation& interactiveAnimation,
+                      std::vector<InputEvent> script,
+                      const QPointF& mousePos) {
+  const std::shared_ptr<Replay> replay = std::make_shared<Replay>();
+  replay->animation =
+      interactiveAnimation(triggerUserInput(mousePos, &replay->triggers));
+  replay->script = std::move(script);
+  replay->next = 0;
+  return Animation::fromValuePullFunc(
+      [replay](double time) { return replay->pull(time); });
+}
+
+boost::optional<std::vector<InputEvent>> readInputScript(
+    std::istream& stream) {
+  std::vector<InputEvent> script;
+  std::string line;
+  while (std::getline(stream, line)) {
+    std::istringstream fields(line);
+    if ((fields >> std::ws).eof() || fields.peek() == '#')
+      continue;
+
+    InputEvent event;
+    std::string typeName;
+    double x, y;
+    if (!(fields >> event.time >> typeName >> x >> y) ||
+        !typeFromName(typeName, &event.type))
+      return boost::none;
+    event.mousePos = QPointF(x, y);
+    if (!(fields >> event.code)) {
+      if (!fields.eof())
+        return boost::none;
+      event.code = 0;
+    } else if (!(fields >> std::ws).eof()) {
+      return boost::none;
+    }
+
+    if (!script.empty() && event.time < script.back().time)
+      return boost::none;
+    script.push_back(event);
+  }
+  return script;
+}
+}
@@ -0,0 +1,60 @@
+#include <sani/inputtriggers.hpp>
+
+#include <sfrp/triggerutil.hpp>
+#include <tuple>
+
+namespace sani {
+
+void InputTriggers::operator()(const std::vector<InputEvent>& batch) const {
+  for (const InputEvent& event : batch) {
+    switch (event.type) {
+      case InputEvent::e_MOUSE_MOVE:
+        if (updateMousePos)
+          updateMousePos(event.mousePos);
+        break;
+      case InputEvent::e_MOUSE_PRESS:
+        if (notifyMousePress)
+          notifyMousePress(event.code);
+        break;
+      case InputEvent::e_MOUSE_RELEASE:
+        if (notifyMouseRelease)
+          notifyMouseRelease(event.code);
+        break;
+      case InputEvent::e_KEY_PRESS:
+        if (notifyKeyPress)
+          notifyKeyPress(event.code);
+        break;
+      case InputEvent::e_KEY_RELEASE:
+        if (notifyKeyRelease)
+          notifyKeyRelease(event.code);
+        break;
+    }
+  }
+  if (notifyInputEvents)
+    notifyInputEvents(batch);
+}
+
+UserInput triggerUserInput(const QPointF& mousePos, InputTriggers* triggers) {
+  UserInput userInput;
+
+  std::tie(userInput.mousePos, triggers->updateMousePos) =
+      sfrp::TriggerUtil::triggerInfStep(mousePos);
+
+  std::tie(userInput.mousePress, triggers->notifyMousePress) =
+      sfrp::TriggerUtil::triggerInf<int>();
+
+  std::tie(userInput.mouseRelease, triggers->notifyMouseRelease) =
+      sfrp::TriggerUtil::triggerInf<int>();
+
+  std::tie(userInput.keyRelease, triggers->notifyKeyRelease) =
+      sfrp::TriggerUtil::triggerInf<int>();
+
+  std::tie(userInput.keyPress, triggers->notifyKeyPress) =
+      sfrp::TriggerUtil::triggerInf<int>();
+
+  std::tie(userInput.inputEvents, triggers->notifyInputEvents) =
+      sfrp::TriggerUtil::triggerInf<std::vector<InputEvent>>();
+
+  return userInput;
+}
+}
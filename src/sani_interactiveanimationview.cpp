@@ -1,23 +1,40 @@
 #include <sani/interactiveanimationview.hpp>
 
+#include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/optional.hpp>
 #include <QApplication>
-#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QFontDatabase>
+#include <QFontMetrics>
 #include <QKeyEvent>
 #include <QMouseEvent>
-#include <QTime>
+#include <QOpenGLWidget>
+#include <QString>
+#include <QStringList>
+#include <QSurfaceFormat>
 #include <sani/animation.hpp>
+#include <sani/animationhost.hpp>
+#include <sani/boundingrect.hpp>
+#include <sani/displaylist.hpp>
 #include <sani/drawing.hpp>
+#include <sani/drawingdiff.hpp>
+#include <sani/framesampler.hpp>
+#include <sani/framescheduler.hpp>
+#include <sani/glrenderer.hpp>
+#include <sani/inputqueue.hpp>
+#include <sani/inputtriggers.hpp>
+#include <sani/optimizedrawing.hpp>
+#include <sani/recording.hpp>
 #include <sani/userinput.hpp>
-#include <sfrp/triggerutil.hpp>
 #include <iostream>
 #include <memory>
 
 namespace sani {
 
-// 17ms ≈ 60Hz
-const int frameIntervalMs = 17;
+// The number of changed regions above which their union is invalidated
+// instead of each region individually.
+const std::size_t maxInvalidatedRegions = 32;
 
 namespace {
 // Return an 'int' corresponding to the specified 'button' or '0' if
@@ -38,22 +55,69 @@ int intFromMouseButton(const Qt::MouseButton& button) {
       return 0;
   }
 }
+
+// Return the font of the frame statistics overlay.
+QFont overlayFont() {
+  return QFontDatabase::systemFont(QFontDatabase::FixedFont);
+}
+
+// Return the specified 'nsecs' formatted as milliseconds.
+QString formatMs(qint64 nsecs) { return QString::number(nsecs / 1e6, 'f', 1); }
+
+// Return a line of the overlay summarizing the specified 'histogram' with the
+// specified 'name'.
+QString overlayLine(const char* name, const RollingHistogram& histogram) {
+  return QString("%1 mean %2 p95 %3 max %4 ms")
+      .arg(QString::fromLatin1(name), -9)
+      .arg(formatMs(histogram.mean()))
+      .arg(formatMs(histogram.quantile(0.95)))
+      .arg(formatMs(histogram.quantile(1.0)));
+}
 }
 
 struct InteractiveAnimationView::Impl {
 
-  Impl() : m_nextFrameContents(drawNothing) {}
+  Impl()
+      : m_nextFrameContents(drawNothing),
+        m_displayListScale(0.0),
+        m_scheduler(new TimerFrameScheduler()),
+        m_pipelinedSampling(false),
+        m_dirtyRegionUpdates(false),
+        m_optimizeFrames(false),
+        m_timeIndependent(false),
+        m_inputSinceLastFrame(false),
+        m_statistics(m_scheduler->intervalNsecs()),
+        m_pendingIntervalNsecs(0),
+        m_hasPendingFrame(false),
+        m_statisticsOverlay(false),
+        m_recordingWriter(0),
+        m_host(0) {}
 
   QGraphicsScene m_scene;
-  QTime m_animationStartTime;
+  QElapsedTimer m_animationStartTime;
   Drawing m_nextFrameContents;
+  boost::optional<DisplayList> m_opNextFrameDisplayList;  // compiled lazily
+  double m_displayListScale;  // 'lodScale' 'm_opNextFrameDisplayList' is for
   boost::optional<Animation> m_opAnimation;
-  boost::function<void(const QPointF&)> m_updateMousePos;
-  boost::function<void(const int)> m_notifyMousePress;
-  boost::function<void(const int)> m_notifyMouseRelease;
-  boost::function<void(const int)> m_notifyKeyPress;
-  boost::function<void(const int)> m_notifyKeyRelease;
-  QBasicTimer m_timer;
+  InputTriggers m_triggers;  // Triggers of the animation's 'UserInput'
+  InputQueue m_inputQueue;  // Input since the last frame
+  std::unique_ptr<FrameScheduler> m_scheduler;
+  std::unique_ptr<FrameSampler> m_sampler;  // Pulls 'm_opAnimation' if set
+  std::unique_ptr<GlRenderer> m_glRenderer;  // Set with an OpenGL viewport
+  bool m_pipelinedSampling;
+  bool m_dirtyRegionUpdates;
+  bool m_optimizeFrames;
+  bool m_timeIndependent;
+  bool m_inputSinceLastFrame;
+  FrameStatistics m_statistics;
+  FrameTiming m_pendingTiming;   // Timing of the last pulled frame so far
+  qint64 m_pendingIntervalNsecs;
+  bool m_hasPendingFrame;
+  QElapsedTimer m_sinceLastFrame;
+  bool m_statisticsOverlay;
+  RecordingWriter* m_recordingWriter;  // Receives presented frames if set
+  QElapsedTimer m_sinceRecordingStarted;
+  AnimationHost* m_host;  // Source of the frames and input sink if set
 };
 
 InteractiveAnimationView::InteractiveAnimationView() : m_impl(new Impl()) {
@@ -61,95 +125,376 @@ InteractiveAnimationView::InteractiveAnimationView() : m_impl(new Impl()) {
   setRenderHint(QPainter::Antialiasing);
   setScene(&m_impl->m_scene);
   setMouseTracking(true);
-  m_impl->m_timer.start(frameIntervalMs, this);
+  connect(m_impl->m_scheduler.get(), &FrameScheduler::frameDue, this,
+          &InteractiveAnimationView::pullNewFrameFromAnimation);
 }
 
 InteractiveAnimationView::~InteractiveAnimationView() {}
 
 void InteractiveAnimationView::drawBackground(QPainter* painter,
                                               const QRectF& rect) {
-  draw(m_impl->m_nextFrameContents, *painter);
+  QElapsedTimer paintTimer;
+  paintTimer.start();
+  // When the whole frame is exposed, nothing can be culled and the batched
+  // display list is the fastest way to paint it. Otherwise skip the subtrees
+  // that are not exposed.
+  const QTransform toDevice = painter->combinedTransform();
+  const QRectF frameDeviceRect =
+      deviceRect(drawingBounds(m_impl->m_nextFrameContents), toDevice);
+  if (toDevice.mapRect(rect).contains(frameDeviceRect)) {
+    // The levels of 'DrawLOD' nodes in the display list depend on the scale.
+    if (!m_impl->m_opNextFrameDisplayList ||
+        lodScale(toDevice) != m_impl->m_displayListScale) {
+      m_impl->m_opNextFrameDisplayList =
+          compile(m_impl->m_nextFrameContents, toDevice);
+      m_impl->m_displayListScale = lodScale(toDevice);
+    }
+    if (m_impl->m_glRenderer && isOpenGLPainter(*painter))
+      m_impl->m_glRenderer->draw(*m_impl->m_opNextFrameDisplayList, *painter);
+    else
+      drawBatched(*m_impl->m_opNextFrameDisplayList, *painter);
+  } else {
+    draw(m_impl->m_nextFrameContents, *painter, rect);
+  }
+  m_impl->m_pendingTiming.paintNsecs += paintTimer.nsecsElapsed();
+}
+
+void InteractiveAnimationView::drawForeground(QPainter* painter,
+                                              const QRectF&) {
+  if (!m_impl->m_statisticsOverlay)
+    return;
+
+  const FrameStatistics& statistics = m_impl->m_statistics;
+  const QStringList lines =
+      QStringList()
+      << overlayLine("pull", statistics.pullTimes())
+      << overlayLine("paint", statistics.paintTimes())
+      << overlayLine("interval", statistics.intervals())
+      << QString("%1 frames, %2 over budget, %3 late")
+             .arg(statistics.frames())
+             .arg(statistics.overBudgetFrames())
+             .arg(statistics.lateFrames());
+
+  painter->save();
+  painter->resetTransform();
+  const QRect area = overlayRect();
+  painter->fillRect(area, QColor(0, 0, 0, 160));
+  painter->setPen(Qt::white);
+  painter->setFont(overlayFont());
+  const QFontMetrics metrics(overlayFont());
+  for (int i = 0; i < lines.size(); ++i)
+    painter->drawText(
+        QPointF(area.left() + metrics.averageCharWidth(),
+                area.top() + (i + 1) * metrics.lineSpacing()),
+        lines[i]);
+  painter->restore();
 }
 
 void InteractiveAnimationView::setInteractiveAnimation(
     const InteractiveAnimation& interactiveAnimation) {
-  sani::UserInput userInput;
-
+  setAnimationHost(0);
+  m_impl->m_sampler.reset();
   const QPoint curMousePos = mapFromGlobal(QCursor::pos());
-  std::tie(userInput.mousePos, m_impl->m_updateMousePos) =
-      sfrp::TriggerUtil::triggerInfStep(rect().contains(curMousePos)
-                                            ? mapToScene(curMousePos)
-                                            : QPointF(0.0, 0.0));
+  const sani::UserInput userInput = triggerUserInput(
+      rect().contains(curMousePos) ? mapToScene(curMousePos)
+                                   : QPointF(0.0, 0.0),
+      &m_impl->m_triggers);
+  m_impl->m_inputQueue.take();
 
-  std::tie(userInput.mousePress, m_impl->m_notifyMousePress) =
-      sfrp::TriggerUtil::triggerInf<int>();
+  m_impl->m_opAnimation = interactiveAnimation(userInput);
+  m_impl->m_animationStartTime.restart();
+  if (m_impl->m_pipelinedSampling)
+    startSampler();
+  m_impl->m_scheduler->start();
+}
 
-  std::tie(userInput.mouseRelease, m_impl->m_notifyMouseRelease) =
-      sfrp::TriggerUtil::triggerInf<int>();
+void InteractiveAnimationView::setAnimationHost(AnimationHost* host) {
+  if (m_impl->m_host)
+    disconnect(m_impl->m_host, 0, this, 0);
+  m_impl->m_host = host;
+  if (!host)
+    return;
 
-  std::tie(userInput.keyRelease, m_impl->m_notifyKeyRelease) =
-      sfrp::TriggerUtil::triggerInf<int>();
+  m_impl->m_sampler.reset();
+  m_impl->m_opAnimation = boost::none;
+  m_impl->m_triggers = InputTriggers();
+  m_impl->m_inputQueue.take();
+  m_impl->m_scheduler->stop();
+  m_impl->m_sinceLastFrame.invalidate();
+  connect(host, &AnimationHost::framePulled, this,
+          &InteractiveAnimationView::presentHostFrame);
+}
 
-  std::tie(userInput.keyPress, m_impl->m_notifyKeyPress) =
-      sfrp::TriggerUtil::triggerInf<int>();
+void InteractiveAnimationView::setPipelinedSampling(bool enabled) {
+  m_impl->m_pipelinedSampling = enabled;
+  if (enabled && m_impl->m_opAnimation && !m_impl->m_sampler)
+    startSampler();
+  else if (!enabled)
+    m_impl->m_sampler.reset();
+}
 
-  m_impl->m_opAnimation = interactiveAnimation(userInput);
-  m_impl->m_animationStartTime.restart();
+void InteractiveAnimationView::setFrameOptimization(bool enabled) {
+  m_impl->m_optimizeFrames = enabled;
+  if (m_impl->m_sampler)
+    m_impl->m_sampler->setOptimization(enabled);
+}
+
+void InteractiveAnimationView::setOpenGLViewport(bool enabled) {
+  if (enabled == bool(m_impl->m_glRenderer))
+    return;
+  if (enabled) {
+    QOpenGLWidget* const glViewport = new QOpenGLWidget();
+    QSurfaceFormat format;
+    format.setSamples(4);
+    glViewport->setFormat(format);
+    setViewport(glViewport);
+    m_impl->m_glRenderer.reset(new GlRenderer());
+  } else {
+    setViewport(new QWidget());
+    m_impl->m_glRenderer.reset();
+  }
+  setMouseTracking(true);
+}
+
+void InteractiveAnimationView::setFrameScheduler(
+    std::unique_ptr<FrameScheduler> scheduler) {
+  const bool active = m_impl->m_scheduler->isActive();
+  m_impl->m_scheduler = std::move(scheduler);
+  connect(m_impl->m_scheduler.get(), &FrameScheduler::frameDue, this,
+          &InteractiveAnimationView::pullNewFrameFromAnimation);
+  m_impl->m_statistics.setBudgetNsecs(m_impl->m_scheduler->intervalNsecs());
+  m_impl->m_sinceLastFrame.invalidate();
+  if (active)
+    m_impl->m_scheduler->start();
+}
+
+FrameScheduler& InteractiveAnimationView::frameScheduler() const {
+  return *m_impl->m_scheduler;
+}
+
+void InteractiveAnimationView::setTimeIndependent(bool timeIndependent) {
+  m_impl->m_timeIndependent = timeIndependent;
+  wake();
+}
+
+void InteractiveAnimationView::setDirtyRegionUpdates(bool enabled) {
+  m_impl->m_dirtyRegionUpdates = enabled;
+  setViewportUpdateMode(enabled ? QGraphicsView::SmartViewportUpdate
+                                : QGraphicsView::FullViewportUpdate);
+}
+
+const FrameStatistics& InteractiveAnimationView::frameStatistics() const {
+  return m_impl->m_statistics;
+}
+
+void InteractiveAnimationView::resetFrameStatistics() {
+  m_impl->m_statistics.reset();
+}
+
+void InteractiveAnimationView::setFrameStatisticsOverlay(bool enabled) {
+  m_impl->m_statisticsOverlay = enabled;
+  viewport()->update(overlayRect());
+}
+
+void InteractiveAnimationView::setRecordingWriter(RecordingWriter* writer) {
+  m_impl->m_recordingWriter = writer;
+  m_impl->m_sinceRecordingStarted.start();
 }
 
 void InteractiveAnimationView::mousePressEvent(QMouseEvent* event) {
-  if (m_impl->m_notifyMousePress)
-    m_impl->m_notifyMousePress(intFromMouseButton(event->button()));
+  queueInput(InputEvent::e_MOUSE_PRESS, mapToScene(event->pos()),
+             intFromMouseButton(event->button()));
 }
 
 void InteractiveAnimationView::mouseReleaseEvent(QMouseEvent* event) {
-  if (m_impl->m_notifyMouseRelease)
-    m_impl->m_notifyMouseRelease(intFromMouseButton(event->button()));
+  queueInput(InputEvent::e_MOUSE_RELEASE, mapToScene(event->pos()),
+             intFromMouseButton(event->button()));
 }
 
 void InteractiveAnimationView::keyPressEvent(QKeyEvent* e) {
-  if (m_impl->m_notifyKeyPress)
-    m_impl->m_notifyKeyPress(e->key());
+  queueInput(InputEvent::e_KEY_PRESS,
+             mapToScene(mapFromGlobal(QCursor::pos())), e->key());
 }
 
 void InteractiveAnimationView::keyReleaseEvent(QKeyEvent* e) {
-  if (m_impl->m_notifyKeyRelease)
-    m_impl->m_notifyKeyRelease(e->key());
-}
-void InteractiveAnimationView::timerEvent(QTimerEvent *event)
-{
-  pullNewFrameFromAnimation();
+  queueInput(InputEvent::e_KEY_RELEASE,
+             mapToScene(mapFromGlobal(QCursor::pos())), e->key());
 }
 
 void InteractiveAnimationView::pullNewFrameFromAnimation() {
-  QTime framePullStart;
-  framePullStart.start();
-  if (m_impl->m_opAnimation) {
-    const int curTimeMilliseconds = m_impl->m_animationStartTime.elapsed();
+  recordPendingFrame();
+  deliverInput();
+  m_impl->m_statistics.setBudgetNsecs(m_impl->m_scheduler->intervalNsecs());
 
-    const double curTimeSeconds = curTimeMilliseconds / 1000.0;
+  if (m_impl->m_sampler) {
+    // Present the frame pulled during the previous tick, if it is finished,
+    // and have the next one pulled while this one is painted.
+    if (const boost::optional<FrameSampler::Frame> opFrame =
+            m_impl->m_sampler->takeFrame())
+      presentFrame(opFrame->opDrawing, opFrame->pullNsecs);
+    if (m_impl->m_sampler)
+      m_impl->m_sampler->requestFrame(
+          animationTime() + m_impl->m_scheduler->intervalNsecs() / 1e9);
+  } else if (m_impl->m_opAnimation) {
+    QElapsedTimer pullTimer;
+    pullTimer.start();
+    boost::optional<sani::Drawing> opDrawing =
+        m_impl->m_opAnimation->pull(animationTime());
+    if (opDrawing && m_impl->m_optimizeFrames)
+      opDrawing = optimizeDrawing(*opDrawing);
+    presentFrame(opDrawing, pullTimer.nsecsElapsed());
+  }
+  if (m_impl->m_statisticsOverlay)
+    viewport()->update(overlayRect());
+}
 
-    const boost::optional<sani::Drawing> opDrawing =
-        m_impl->m_opAnimation->pull(curTimeSeconds);
+void InteractiveAnimationView::presentHostFrame(
+    const boost::optional<Drawing>& opDrawing,
+    qint64 pullNsecs) {
+  recordPendingFrame();
+  m_impl->m_statistics.setBudgetNsecs(
+      m_impl->m_host->frameScheduler().intervalNsecs());
+  presentFrame(opDrawing, pullNsecs);
+  if (m_impl->m_statisticsOverlay)
+    viewport()->update(overlayRect());
+}
 
-    if (opDrawing) {
-      m_impl->m_nextFrameContents = *opDrawing;
+void InteractiveAnimationView::presentFrame(
+    const boost::optional<Drawing>& opDrawing,
+    qint64 pullNsecs) {
+  const qint64 intervalNsecs = m_impl->m_sinceLastFrame.isValid()
+                                   ? m_impl->m_sinceLastFrame.nsecsElapsed()
+                                   : 0;
+  m_impl->m_sinceLastFrame.start();
+
+  // A time-independent animation can only change after user input, so once a
+  // frame without preceding input is unchanged, ticking is stopped until the
+  // next input. A host stops ticking by itself.
+  const bool mayIdle = m_impl->m_timeIndependent && !m_impl->m_host &&
+                       !m_impl->m_inputSinceLastFrame;
+  m_impl->m_inputSinceLastFrame = false;
+
+  if (opDrawing && m_impl->m_recordingWriter)
+    m_impl->m_recordingWriter->addFrame(
+        m_impl->m_sinceRecordingStarted.nsecsElapsed() / 1e9, *opDrawing);
+
+  if (opDrawing) {
+    if (m_impl->m_dirtyRegionUpdates || mayIdle) {
+      const std::vector<DrawingBounds> changed =
+          changedBounds(m_impl->m_nextFrameContents, *opDrawing);
+      if (mayIdle && changed.empty()) {
+        m_impl->m_scheduler->stop();
+        m_impl->m_sinceLastFrame.invalidate();
+      }
+      if (m_impl->m_dirtyRegionUpdates)
+        invalidateRegions(changed);
+      else if (!changed.empty())
+        m_impl->m_scene.invalidate();
+      if (!changed.empty()) {
+        m_impl->m_nextFrameContents = *opDrawing;
+        m_impl->m_opNextFrameDisplayList = boost::none;
+      }
     } else {
-      m_impl->m_opAnimation = boost::none;
-      m_impl->m_updateMousePos.clear();
+      m_impl->m_scene.invalidate();
+      m_impl->m_nextFrameContents = *opDrawing;
+      m_impl->m_opNextFrameDisplayList = boost::none;
     }
+  } else {
+    m_impl->m_sampler.reset();
+    m_impl->m_opAnimation = boost::none;
+    m_impl->m_triggers.updateMousePos.clear();
     m_impl->m_scene.invalidate();
+    m_impl->m_scheduler->stop();
+    m_impl->m_sinceLastFrame.invalidate();
+  }
+  m_impl->m_pendingTiming = FrameTiming();
+  m_impl->m_pendingTiming.pullNsecs = pullNsecs;
+  m_impl->m_pendingIntervalNsecs = intervalNsecs;
+  m_impl->m_hasPendingFrame = true;
+}
+
+double InteractiveAnimationView::animationTime() const {
+  return m_impl->m_animationStartTime.nsecsElapsed() / 1e9;
+}
+
+void InteractiveAnimationView::queueInput(InputEvent::Type type,
+                                          const QPointF& mousePos,
+                                          int code) {
+  wake();
+  if (m_impl->m_host) {
+    if (hasFocus())
+      m_impl->m_host->postInput(
+          InputEvent(type, m_impl->m_host->time(), mousePos, code));
+  } else if (m_impl->m_opAnimation) {
+    m_impl->m_inputQueue.push(
+        InputEvent(type, animationTime(), mousePos, code));
   }
-  const int framePullDuration = framePullStart.elapsed();
-  // Process pending events to ensure that the timer's events don't monopolize
-  // the event buffer and cause weird behavior, such as mouse freezing. See
-  // issue 216696 for more information.
-  qApp->processEvents();
+}
+
+void InteractiveAnimationView::deliverInput() {
+  if (m_impl->m_inputQueue.empty())
+    return;
+  deliver(boost::bind(m_impl->m_triggers, m_impl->m_inputQueue.take()));
+}
+
+void InteractiveAnimationView::deliver(const boost::function<void()>& input) {
+  if (m_impl->m_sampler)
+    m_impl->m_sampler->post(input);
+  else
+    input();
+}
+
+void InteractiveAnimationView::startSampler() {
+  m_impl->m_sampler.reset(new FrameSampler(*m_impl->m_opAnimation));
+  m_impl->m_sampler->setOptimization(m_impl->m_optimizeFrames);
+  m_impl->m_sampler->requestFrame(animationTime());
+}
+
+void InteractiveAnimationView::wake() {
+  m_impl->m_inputSinceLastFrame = true;
+  if (m_impl->m_opAnimation)
+    m_impl->m_scheduler->start();
+}
+
+void InteractiveAnimationView::invalidateRegions(
+    const std::vector<DrawingBounds>& changed) {
+  if (changed.empty())
+    return;
+
+  // The bounds' cosmetic margins are in device pixels, so the regions are
+  // mapped to the viewport and back to include them.
+  const QTransform toViewport = viewportTransform();
+  const QTransform fromViewport = toViewport.inverted();
+  if (changed.size() > maxInvalidatedRegions) {
+    QRectF viewportRect;
+    for (const DrawingBounds& bounds : changed)
+      viewportRect |= deviceRect(bounds, toViewport);
+    m_impl->m_scene.invalidate(fromViewport.mapRect(viewportRect),
+                               QGraphicsScene::BackgroundLayer);
+  } else {
+    for (const DrawingBounds& bounds : changed)
+      m_impl->m_scene.invalidate(
+          fromViewport.mapRect(deviceRect(bounds, toViewport)),
+          QGraphicsScene::BackgroundLayer);
+  }
+}
+
+void InteractiveAnimationView::recordPendingFrame() {
+  if (!m_impl->m_hasPendingFrame)
+    return;
+  m_impl->m_hasPendingFrame = false;
+  m_impl->m_statistics.addFrame(m_impl->m_pendingTiming,
+                                m_impl->m_pendingIntervalNsecs);
+  Q_EMIT frameTimed(m_impl->m_pendingTiming, m_impl->m_pendingIntervalNsecs);
+}
+
+QRect InteractiveAnimationView::overlayRect() const {
+  const QFontMetrics metrics(overlayFont());
+  return QRect(0, 0, 48 * metrics.averageCharWidth(),
+               4 * metrics.lineSpacing() + metrics.descent() + 2);
 }
 
 void InteractiveAnimationView::mouseMoveEvent(QMouseEvent* e) {
-  const QPointF p = mapToScene(e->pos());
-  if (m_impl->m_updateMousePos)
-    m_impl->m_updateMousePos(p);
+  queueInput(InputEvent::e_MOUSE_MOVE, mapToScene(e->pos()), 0);
 }
 }
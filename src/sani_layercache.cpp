@@ -0,0 +1,183 @@
+#include <sani/layercache.hpp>
+
+#include <sani/boundingrect.hpp>
+#include <sani/drawingdiff.hpp>
+#include <sani/lrucache.hpp>
+
+#include <boost/functional/hash.hpp>
+#include <boost/optional.hpp>
+#include <QImage>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+namespace sani {
+
+namespace {
+// The largest width or height, in pixels, of a cached layer
+const int maxLayerExtent = 4096;
+
+// The default capacity of the cache in bytes
+const std::size_t defaultCapacity = 64 * 1024 * 1024;
+
+// The number of scale steps per doubling of the scale
+const int stepsPerOctave = 4;
+
+// The identity of a cached layer
+struct LayerKey {
+  LayerKey(std::size_t hash_, int scaleStep_, QPainter::RenderHints hints_)
+      : hash(hash_), scaleStep(scaleStep_), hints(hints_) {}
+
+  bool operator==(const LayerKey& other) const {
+    return hash == other.hash && scaleStep == other.scaleStep &&
+           hints == other.hints;
+  }
+
+  std::size_t hash;             // Structural hash of the drawing
+  int scaleStep;                // Quantized scale it is rasterized at
+  QPainter::RenderHints hints;  // Render hints it is rasterized with
+};
+
+std::size_t hash_value(const LayerKey& key) {
+  std::size_t seed = key.hash;
+  boost::hash_combine(seed, key.scaleStep);
+  boost::hash_combine(seed, int(key.hints));
+  return seed;
+}
+
+// A rasterized drawing, the rectangle, in drawing coordinates, it covers, and
+// the drawing itself, which tells layers of drawings with colliding hashes
+// apart. A null 'image' denotes a drawing that paints nothing.
+struct Layer {
+  QImage image;
+  QRectF target;
+  std::shared_ptr<const Drawing> source;
+};
+
+struct Cache {
+  Cache() : layers(defaultCapacity) {}
+
+  std::mutex mutex;
+  LruCache<LayerKey, Layer> layers;
+};
+
+Cache& cache() {
+  static Cache instance;
+  return instance;
+}
+
+// Return the larger of the scale factors along the two axes of the specified
+// 't'.
+qreal scaleOf(const QTransform& t) {
+  return std::max(std::sqrt(t.m11() * t.m11() + t.m12() * t.m12()),
+                  std::sqrt(t.m21() * t.m21() + t.m22() * t.m22()));
+}
+
+// Return the smallest scale step whose scale is at least the specified
+// 'scale'.
+int scaleStep(qreal scale) {
+  return int(std::ceil(std::log2(scale) * stepsPerOctave));
+}
+
+// Return the scale of the specified 'step'.
+qreal stepScale(int step) {
+  return std::pow(2.0, double(step) / stepsPerOctave);
+}
+
+// Return the specified 'd' rasterized at the specified 'scale' with the render
+// hints of the specified 'painter', or 'boost::none' if the layer would be too
+// large.
+boost::optional<Layer> rasterize(const Drawing& d,
+                                 qreal scale,
+                                 const QPainter& painter) {
+  Layer result;
+  const DrawingBounds bounds = drawingBounds(d);
+  if (bounds.isEmpty)
+    return result;
+
+  const qreal margin = std::ceil(bounds.cosmeticMargin);
+  const qreal width = std::ceil(bounds.rect.width() * scale + 2 * margin);
+  const qreal height = std::ceil(bounds.rect.height() * scale + 2 * margin);
+  if (width > maxLayerExtent || height > maxLayerExtent)
+    return boost::none;
+
+  result.image =
+      QImage(int(width), int(height), QImage::Format_ARGB32_Premultiplied);
+  result.image.fill(Qt::transparent);
+  QPainter layerPainter(&result.image);
+  layerPainter.setRenderHints(painter.renderHints());
+  layerPainter.translate(margin, margin);
+  layerPainter.scale(scale, scale);
+  layerPainter.translate(-bounds.rect.left(), -bounds.rect.top());
+  draw(d, layerPainter);
+  layerPainter.end();
+
+  result.target = QRectF(bounds.rect.left() - margin / scale,
+                         bounds.rect.top() - margin / scale, width / scale,
+                         height / scale);
+  return result;
+}
+
+// Paint the specified 'd' directly using the specified 'painter', leaving the
+// pen, brush, and font of 'painter' unchanged.
+void paintDirect(const Drawing& d, QPainter& painter) {
+  painter.save();
+  draw(d, painter);
+  painter.restore();
+}
+}
+
+void paintCached(const DrawCached& d, QPainter& painter) {
+  const QTransform t = painter.combinedTransform();
+  if (t.type() == QTransform::TxProject) {
+    paintDirect(*d.d, painter);
+    return;
+  }
+  const qreal devicePixelRatio =
+      painter.device() ? painter.device()->devicePixelRatioF() : 1.0;
+  const qreal scale = scaleOf(t) * devicePixelRatio;
+  if (!(scale > 0.0))
+    return;
+
+  const LayerKey key(d.hash, scaleStep(scale), painter.renderHints());
+  boost::optional<Layer> opLayer;
+  {
+    std::lock_guard<std::mutex> lock(cache().mutex);
+    opLayer = cache().layers.find(key);
+  }
+  if (opLayer && opLayer->source != d.d &&
+      !structurallyEqual(*opLayer->source, *d.d))
+    opLayer = boost::none;
+  if (!opLayer) {
+    opLayer = rasterize(*d.d, stepScale(key.scaleStep), painter);
+    if (!opLayer) {
+      paintDirect(*d.d, painter);
+      return;
+    }
+    opLayer->source = d.d;
+    const std::size_t bytes =
+        std::size_t(opLayer->image.bytesPerLine()) * opLayer->image.height();
+    std::lock_guard<std::mutex> lock(cache().mutex);
+    cache().layers.insert(key, *opLayer, bytes);
+  }
+  if (opLayer->image.isNull())
+    return;
+
+  const bool smooth = painter.testRenderHint(QPainter::SmoothPixmapTransform);
+  painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+  painter.drawImage(opLayer->target, opLayer->image);
+  painter.setRenderHint(QPainter::SmoothPixmapTransform, smooth);
+}
+
+void setLayerCacheCapacity(std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(cache().mutex);
+  cache().layers.setMaxCost(bytes);
+}
+
+void clearLayerCache() {
+  std::lock_guard<std::mutex> lock(cache().mutex);
+  cache().layers.clear();
+}
+}
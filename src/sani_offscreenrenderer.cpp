@@ -0,0 +1,53 @@
+#include <sani/offscreenrenderer.hpp>
+
+#include <sani/displaylist.hpp>
+#include <sani/drawing.hpp>
+
+#include <QElapsedTimer>
+#include <QSize>
+
+namespace sani {
+
+OffscreenRenderer::OffscreenRenderer(const Animation& animation,
+                                     const QSize& size)
+    : m_animation(animation),
+      m_image(size, QImage::Format_ARGB32_Premultiplied),
+      m_background(Qt::white),
+      m_renderHints(QPainter::Antialiasing) {
+  m_image.fill(m_background);
+}
+
+void OffscreenRenderer::setTransform(const QTransform& t) { m_transform = t; }
+
+void OffscreenRenderer::setBackground(const QColor& color) {
+  m_background = color;
+}
+
+void OffscreenRenderer::setRenderHints(QPainter::RenderHints hints) {
+  m_renderHints = hints;
+}
+
+boost::optional<FrameTiming> OffscreenRenderer::renderFrame(double time) {
+  FrameTiming timing;
+  QElapsedTimer timer;
+
+  timer.start();
+  const boost::optional<Drawing> opDrawing = m_animation.pull(time);
+  timing.pullNsecs = timer.nsecsElapsed();
+  if (!opDrawing)
+    return boost::none;
+
+  timer.restart();
+  m_image.fill(m_background);
+  QPainter painter(&m_image);
+  painter.setRenderHints(m_renderHints);
+  painter.setTransform(m_transform);
+  drawBatched(compile(*opDrawing, m_transform), painter);
+  painter.end();
+  timing.paintNsecs = timer.nsecsElapsed();
+
+  return timing;
+}
+
+const QImage& OffscreenRenderer::image() const { return m_image; }
+}
@@ -0,0 +1,194 @@
+#include <sani/optimizedrawing.hpp>
+
+#include <sani/rewritedrawing.hpp>
+
+#include <QRectF>
+
+namespace sani {
+
+namespace {
+// Return 'true' if the specified 'brush' paints nothing, not considering its
+// colour if the specified 'recolored' is 'true', and 'false' otherwise.
+bool invisible(const QBrush& brush, bool recolored) {
+  return brush.style() == Qt::NoBrush ||
+         (!recolored && brush.style() == Qt::SolidPattern &&
+          brush.color().alpha() == 0);
+}
+
+// Return 'true' if the specified 'pen' paints nothing, not considering its
+// colour if the specified 'recolored' is 'true', and 'false' otherwise. Note
+// that setting the colour of a pen also replaces its brush.
+bool invisible(const QPen& pen, bool recolored) {
+  return pen.style() == Qt::NoPen ||
+         (!recolored && invisible(pen.brush(), false));
+}
+
+// This class implements a visitor that returns whether a primitive paints
+// anything.
+class Visible : public boost::static_visitor<bool> {
+ public:
+  // Create a 'Visible' object for primitives whose colours are replaced when
+  // painted if the specified 'recolored' is 'true'.
+  explicit Visible(bool recolored) : m_recolored(recolored) {}
+
+  bool operator()(const DrawPoint& d) const { return stroked(d.pen); }
+  bool operator()(const DrawLine& d) const { return stroked(d.pen); }
+  bool operator()(const DrawRect& d) const {
+    return stroked(d.pen) || filled(d.brush, d.rect);
+  }
+  bool operator()(const DrawRoundedRect& d) const {
+    return stroked(d.pen) || filled(d.brush, d.rect);
+  }
+  bool operator()(const DrawText& d) const {
+    return !d.text.empty() && stroked(d.pen);
+  }
+  bool operator()(const DrawEllipse& d) const {
+    return stroked(d.pen) || filled(d.brush, d.rect);
+  }
+  bool operator()(const DrawArc& d) const { return stroked(d.pen); }
+  bool operator()(const DrawPie& d) const {
+    return stroked(d.pen) || (d.spanAngle != 0.0 && filled(d.brush, d.rect));
+  }
+  bool operator()(const DrawChord& d) const {
+    return stroked(d.pen) || (d.spanAngle != 0.0 && filled(d.brush, d.rect));
+  }
+  template <typename Composite>
+  bool operator()(const Composite&) const {
+    return true;
+  }
+
+ private:
+  // Return 'true' if the specified 'pen' paints anything.
+  bool stroked(const QPen& pen) const { return !invisible(pen, m_recolored); }
+
+  // Return 'true' if the specified 'brush' paints anything in the specified
+  // 'rect'.
+  bool filled(const QBrush& brush, const QRectF& rect) const {
+    return rect.width() != 0.0 && rect.height() != 0.0 &&
+           !invisible(brush, m_recolored);
+  }
+
+  const bool m_recolored;
+};
+
+// This class implements the rules of 'optimizeDrawing'. The context of a node
+// is 1 if its colours are replaced when painted, and 0 otherwise.
+class Optimizer : public DrawingRewriter {
+ public:
+  Optimizer() : m_nothing(std::make_shared<const Drawing>(drawNothing)) {}
+
+  void appendOperands(const DrawingNode& node, int recolored,
+                      std::vector<Operand>& operands) override {
+    if (const DrawOver* const over = boost::get<DrawOver>(node.get())) {
+      operands.push_back(Operand(over->d1, recolored));
+      operands.push_back(Operand(over->d2, recolored));
+    } else if (const DrawGroup* const group =
+                   boost::get<DrawGroup>(node.get())) {
+      for (const Drawing& child : *group->children)
+        operands.push_back(
+            Operand(DrawingNode(group->children, &child), recolored));
+    } else if (const DrawTransform* const transform =
+                   boost::get<DrawTransform>(node.get())) {
+      operands.push_back(Operand(transform->d, recolored));
+    } else if (const DrawInstances* const instances =
+                   boost::get<DrawInstances>(node.get())) {
+      operands.push_back(
+          Operand(instances->d, recolored || !instances->colors->empty()));
+    } else if (const DrawLOD* const lod = boost::get<DrawLOD>(node.get())) {
+      for (const Drawing& level : *lod->levels)
+        operands.push_back(
+            Operand(DrawingNode(lod->levels, &level), recolored));
+    }
+  }
+
+  DrawingNode rebuild(const DrawingNode& node, int recolored,
+                      const DrawingNode* first, std::size_t arity) override {
+    const DrawingNode* const last = first + arity;
+    if (const DrawOver* const over = boost::get<DrawOver>(node.get())) {
+      const DrawingNode& d1 = first[0];
+      const DrawingNode& d2 = first[1];
+      if (isNothing(d1))
+        return d2;
+      if (isNothing(d2))
+        return d1;
+      if (d1 != over->d1 || d2 != over->d2)
+        return std::make_shared<const Drawing>(DrawOver(d1, d2));
+    } else if (const DrawGroup* const group =
+                   boost::get<DrawGroup>(node.get())) {
+      std::vector<DrawingNode> children;
+      for (const DrawingNode* it = first; it != last; ++it)
+        if (!isNothing(*it))
+          children.push_back(*it);
+      if (children.empty())
+        return m_nothing;
+      if (children.size() == 1)
+        return children.front();
+      if (!sameDrawings(*group->children, children.data(), children.size()))
+        return std::make_shared<const Drawing>(
+            DrawGroup(copyDrawings(children.data(), children.size())));
+    } else if (const DrawTransform* const transform =
+                   boost::get<DrawTransform>(node.get())) {
+      const DrawingNode result = transformed(transform->t, *first);
+      if (result != transform->d)
+        return result;
+    } else if (const DrawInstances* const instances =
+                   boost::get<DrawInstances>(node.get())) {
+      if (isNothing(*first) || instances->transforms->empty())
+        return m_nothing;
+      if (*first != instances->d) {
+        DrawInstances copy(*instances);
+        copy.d = *first;
+        return std::make_shared<const Drawing>(std::move(copy));
+      }
+    } else if (const DrawLOD* const lod = boost::get<DrawLOD>(node.get())) {
+      bool empty = true;
+      for (const DrawingNode* it = first; it != last; ++it)
+        empty = empty && isNothing(*it);
+      if (empty)
+        return m_nothing;
+      if (!sameDrawings(*lod->levels, first, arity)) {
+        DrawLOD copy(*lod);
+        copy.levels = std::make_shared<const std::vector<Drawing>>(
+            copyDrawings(first, arity));
+        return std::make_shared<const Drawing>(std::move(copy));
+      }
+    } else if (isNothing(node) ||
+               !boost::apply_visitor(Visible(recolored != 0), *node)) {
+      return m_nothing;
+    }
+    return node;
+  }
+
+ private:
+  // Return the optimized form of the specified 'd', which is optimized,
+  // transformed by the specified 't'. Return 'd' itself if 't' is the
+  // identity.
+  DrawingNode transformed(const QTransform& t, const DrawingNode& d) const {
+    if (isNothing(d))
+      return m_nothing;
+    QTransform product = t;
+    DrawingNode child = d;
+    if (const DrawTransform* const inner = boost::get<DrawTransform>(d.get())) {
+      product = inner->t * t;
+      child = inner->d;
+    }
+    if (product.isIdentity())
+      return child;
+    return std::make_shared<const Drawing>(DrawTransform(product, child));
+  }
+
+  // Return 'true' if the specified 'node' is a 'DrawNothing', and 'false'
+  // otherwise.
+  static bool isNothing(const DrawingNode& node) {
+    return boost::get<DrawNothing>(node.get()) != 0;
+  }
+
+  const DrawingNode m_nothing;
+};
+}
+
+Drawing optimizeDrawing(const Drawing& d) {
+  Optimizer optimizer;
+  return rewriteDrawing(d, optimizer);
+}
+}
@@ -0,0 +1,41 @@
+#include <sani/painterstatecache.hpp>
+
+#include <QPainter>
+
+namespace sani {
+
+PainterStateCache::PainterStateCache(QPainter& painter)
+    : m_painter(painter),
+      m_pen(painter.pen()),
+      m_brush(painter.brush()),
+      m_font(painter.font()),
+      m_worldTransform(painter.worldTransform()) {}
+
+void PainterStateCache::setPen(const QPen& pen) {
+  if (pen != m_pen) {
+    m_pen = pen;
+    m_painter.setPen(pen);
+  }
+}
+
+void PainterStateCache::setBrush(const QBrush& brush) {
+  if (brush != m_brush) {
+    m_brush = brush;
+    m_painter.setBrush(brush);
+  }
+}
+
+void PainterStateCache::setFont(const QFont& font) {
+  if (font != m_font) {
+    m_font = font;
+    m_painter.setFont(font);
+  }
+}
+
+void PainterStateCache::setWorldTransform(const QTransform& transform) {
+  if (transform != m_worldTransform) {
+    m_worldTransform = transform;
+    m_painter.setWorldTransform(transform);
+  }
+}
+}
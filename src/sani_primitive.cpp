@@ -0,0 +1,235 @@
+#include <sani/primitive.hpp>
+
+#include <sani/layercache.hpp>
+#include <sani/painterstatecache.hpp>
+#include <sani/textcache.hpp>
+
+#include <QPainter>
+
+namespace sani {
+
+namespace {
+// Return the specified 'degreesValue', which is in degrees units, in 16ths of
+// a degree units. Note that 16ths of a degree is the standard angle unit in
+// the Qt library.
+int degToDeg16(const qreal& degreesValue) { return degreesValue * 16; }
+
+// This class implements the state setting interface of 'PainterStateCache' by
+// forwarding every change directly to a 'QPainter'.
+struct DirectState {
+  explicit DirectState(QPainter& painter) : m_painter(painter) {}
+
+  void setPen(const QPen& pen) { m_painter.setPen(pen); }
+  void setBrush(const QBrush& brush) { m_painter.setBrush(brush); }
+  void setFont(const QFont& font) { m_painter.setFont(font); }
+  QPainter& painter() const { return m_painter; }
+
+  QPainter& m_painter;
+};
+
+// Paint the specified primitive 'd' after making the required style changes
+// through the specified 'state'. 'State' must be 'DirectState' or
+// 'PainterStateCache'.
+template <typename State>
+void paint(const DrawPoint& d, State& state) {
+  state.setPen(d.pen);
+  state.painter().drawPoint(d.p);
+}
+
+template <typename State>
+void paint(const DrawLine& d, State& state) {
+  state.setPen(d.pen);
+  state.painter().drawLine(d.p1, d.p2);
+}
+
+template <typename State>
+void paint(const DrawRect& d, State& state) {
+  state.setPen(d.pen);
+  state.setBrush(d.brush);
+  state.painter().drawRect(d.rect);
+}
+
+template <typename State>
+void paint(const DrawRoundedRect& d, State& state) {
+  state.setPen(d.pen);
+  state.setBrush(d.brush);
+  state.painter().drawRoundedRect(
+      d.rect, d.xRadius, d.yRadius,
+      d.absolute ? Qt::AbsoluteSize : Qt::RelativeSize);
+}
+
+template <typename State>
+void paint(const DrawText& d, State& state) {
+  state.setPen(d.pen);
+  state.setBrush(d.brush);
+  state.setFont(d.font);
+  paintText(d, state.painter());
+}
+
+template <typename State>
+void paint(const DrawEllipse& d, State& state) {
+  state.setPen(d.pen);
+  state.setBrush(d.brush);
+  state.painter().drawEllipse(d.rect);
+}
+
+template <typename State>
+void paint(const DrawArc& d, State& state) {
+  state.setPen(d.pen);
+  state.setBrush(d.brush);
+  state.painter().drawArc(d.rect, degToDeg16(d.startAngle),
+                          degToDeg16(d.spanAngle));
+}
+
+template <typename State>
+void paint(const DrawPie& d, State& state) {
+  state.setPen(d.pen);
+  state.setBrush(d.brush);
+  state.painter().drawPie(d.rect, degToDeg16(d.startAngle),
+                          degToDeg16(d.spanAngle));
+}
+
+template <typename State>
+void paint(const DrawChord& d, State& state) {
+  state.setPen(d.pen);
+  state.setBrush(d.brush);
+  state.painter().drawChord(d.rect, degToDeg16(d.startAngle),
+                            degToDeg16(d.spanAngle));
+}
+
+template <typename State>
+void paint(const DrawCached& d, State& state) {
+  paintCached(d, state.painter());
+}
+
+// This class implements a visitor that paints any 'Primitive'.
+template <typename State>
+struct PaintPrimitive : boost::static_visitor<> {
+  explicit PaintPrimitive(State& state) : m_state(state) {}
+
+  template <typename T>
+  void operator()(const T& d) const {
+    paint(d, m_state);
+  }
+
+  State& m_state;
+};
+
+// This class implements a visitor that sets the colour of the pen and brush
+// of a 'Primitive'.
+struct Recolor : boost::static_visitor<> {
+  explicit Recolor(const QColor& color) : m_color(color) {}
+
+  template <typename T>
+  void operator()(T& d) const {
+    d.pen.setColor(m_color);
+    d.brush.setColor(m_color);
+  }
+  void operator()(DrawPoint& d) const { d.pen.setColor(m_color); }
+  void operator()(DrawLine& d) const { d.pen.setColor(m_color); }
+  void operator()(DrawCached&) const {}
+
+  const QColor& m_color;
+};
+
+// Paint the specified primitive 'd' using the specified 'painter'.
+template <typename T>
+void paintDirect(const T& d, QPainter& painter) {
+  DirectState state(painter);
+  paint(d, state);
+}
+}
+
+void paintPrimitive(const DrawPoint& d, QPainter& painter) {
+  paintDirect(d, painter);
+}
+
+void paintPrimitive(const DrawLine& d, QPainter& painter) {
+  paintDirect(d, painter);
+}
+
+void paintPrimitive(const DrawRect& d, QPainter& painter) {
+  paintDirect(d, painter);
+}
+
+void paintPrimitive(const DrawRoundedRect& d, QPainter& painter) {
+  paintDirect(d, painter);
+}
+
+void paintPrimitive(const DrawText& d, QPainter& painter) {
+  paintDirect(d, painter);
+}
+
+void paintPrimitive(const DrawEllipse& d, QPainter& painter) {
+  paintDirect(d, painter);
+}
+
+void paintPrimitive(const DrawArc& d, QPainter& painter) {
+  paintDirect(d, painter);
+}
+
+void paintPrimitive(const DrawPie& d, QPainter& painter) {
+  paintDirect(d, painter);
+}
+
+void paintPrimitive(const DrawChord& d, QPainter& painter) {
+  paintDirect(d, painter);
+}
+
+void paintPrimitive(const DrawCached& d, QPainter& painter) {
+  paintDirect(d, painter);
+}
+
+void paintPrimitive(const Primitive& p, QPainter& painter) {
+  DirectState state(painter);
+  boost::apply_visitor(PaintPrimitive<DirectState>(state), p);
+}
+
+void paintPrimitive(const DrawPoint& d, PainterStateCache& state) {
+  paint(d, state);
+}
+
+void paintPrimitive(const DrawLine& d, PainterStateCache& state) {
+  paint(d, state);
+}
+
+void paintPrimitive(const DrawRect& d, PainterStateCache& state) {
+  paint(d, state);
+}
+
+void paintPrimitive(const DrawRoundedRect& d, PainterStateCache& state) {
+  paint(d, state);
+}
+
+void paintPrimitive(const DrawText& d, PainterStateCache& state) {
+  paint(d, state);
+}
+
+void paintPrimitive(const DrawEllipse& d, PainterStateCache& state) {
+  paint(d, state);
+}
+
+void paintPrimitive(const DrawArc& d, PainterStateCache& state) {
+  paint(d, state);
+}
+
+void paintPrimitive(const DrawPie& d, PainterStateCache& state) {
+  paint(d, state);
+}
+
+void paintPrimitive(const DrawChord& d, PainterStateCache& state) {
+  paint(d, state);
+}
+
+void paintPrimitive(const DrawCached& d, PainterStateCache& state) {
+  paint(d, state);
+}
+
+void paintPrimitive(const Primitive& p, PainterStateCache& state) {
+  boost::apply_visitor(PaintPrimitive<PainterStateCache>(state), p);
+}
+
+void recolor(Primitive& p, const QColor& color) {
+  boost::apply_visitor(Recolor(color), p);
+}
+}
@@ -0,0 +1,834 @@
+#include <sani/recording.hpp>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QIODevice>
+#include <QString>
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sani {
+
+namespace {
+// A recording consists of the following parts, written with 'QDataStream'.
+//..
+// recording   := magic version frame* index indexOffset
+// magic       := the 7 bytes "SANIREC"
+// version     := quint8
+// frame       := quint8 kind, double time,
+//                table<QPen>, table<QBrush>, table<QFont>, table<QByteArray>,
+//                quint32 nodeCount, node*, quint32 rootId
+// table<T>    := quint32 count, T*
+// index       := quint32 frameCount, (double time, quint64 offset, quint8 kind)*
+// indexOffset := quint64
+//..
+// The tables of a frame hold the pens, brushes, fonts, and strings that were
+// first used by the frame, and its nodes are the nodes that no earlier frame
+// stored. Each table and the nodes are numbered consecutively in the order
+// they were stored since the last keyframe. A node refers to interned values
+// and to its children, which are stored before it, by these numbers.
+//
+// Offsets are positions in the device the recording was written to, which
+// need not start at the beginning of the device. The recording starts
+// 'headerSize' bytes before its first frame, or before its index if it has no
+// frames.
+const char magic[] = {'S', 'A', 'N', 'I', 'R', 'E', 'C'};
+const int magicSize = int(sizeof(magic));
+const quint8 version = 2;
+const int headerSize = magicSize + 1;
+const int indexOffsetSize = 8;
+
+// Kinds of frames
+enum FrameKind { e_KEYFRAME, e_DELTA_FRAME };
+
+// Tags of the stored nodes
+enum NodeTag {
+  e_POINT,
+  e_LINE,
+  e_RECT,
+  e_ROUNDED_RECT,
+  e_TEXT,
+  e_ELLIPSE,
+  e_ARC,
+  e_PIE,
+  e_CHORD,
+  e_NOTHING,
+  e_OVER,
+  e_TRANSFORM,
+  e_CACHED,
+  e_INSTANCES,
+  e_GROUP,
+  e_LOD
+};
+
+typedef std::shared_ptr<const Drawing> Node;
+
+// Set up the specified 'stream' to read or write the recording format. Since
+// 'Qt_5_5', texture brushes made from a 'QImage' are written as one, so
+// decoding them creates no 'QPixmap', which only the GUI thread may use.
+void configure(QDataStream& stream) {
+  stream.setVersion(QDataStream::Qt_5_5);
+  stream.setByteOrder(QDataStream::BigEndian);
+  stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+}
+
+// Return the specified 'value' serialized in the recording format.
+template <typename T>
+QByteArray serialized(const T& value) {
+  QByteArray result;
+  QDataStream stream(&result, QIODevice::WriteOnly);
+  configure(stream);
+  stream << value;
+  return result;
+}
+
+// Append the children of the specified 'node' to the specified 'children'.
+void appendChildren(const Node& node, std::vector<Node>& children) {
+  if (const DrawOver* const over = boost::get<DrawOver>(node.get())) {
+    children.push_back(over->d1);
+    children.push_back(over->d2);
+  } else if (const DrawTransform* const transform =
+                 boost::get<DrawTransform>(node.get())) {
+    children.push_back(transform->d);
+  } else if (const DrawCached* const cached =
+                 boost::get<DrawCached>(node.get())) {
+    children.push_back(cached->d);
+  } else if (const DrawInstances* const instances =
+                 boost::get<DrawInstances>(node.get())) {
+    children.push_back(instances->d);
+  } else if (const DrawGroup* const group = boost::get<DrawGroup>(
+                 node.get())) {
+    for (const Drawing& child : *group->children)
+      children.push_back(Node(group->children, &child));
+  } else if (const DrawLOD* const lod = boost::get<DrawLOD>(node.get())) {
+    for (const Drawing& level : *lod->levels)
+      children.push_back(Node(lod->levels, &level));
+  }
+}
+
+// This class implements a table of the serialized values interned since the
+// last keyframe.
+class InternTable {
+ public:
+  InternTable() : m_addedCount(0) {}
+
+  // Return the number of the value with the specified serialized 'bytes',
+  // adding it to the table if it is new.
+  quint32 intern(const QByteArray& bytes) {
+    const QHash<QByteArray, quint32>::const_iterator it =
+        m_numbers.constFind(bytes);
+    if (it != m_numbers.constEnd())
+      return it.value();
+    const quint32 number = quint32(m_numbers.size());
+    m_numbers.insert(bytes, number);
+    m_added.append(bytes);
+    ++m_addedCount;
+    return number;
+  }
+
+  // Write the values added since the previous call to the specified 'out' as
+  // a 'table'.
+  void writeAdded(QDataStream& out) {
+    out << m_addedCount;
+    out.writeRawData(m_added.constData(), m_added.size());
+    m_added.clear();
+    m_addedCount = 0;
+  }
+
+  // Remove all values.
+  void clear() {
+    m_numbers.clear();
+    m_added.clear();
+    m_addedCount = 0;
+  }
+
+ private:
+  QHash<QByteArray, quint32> m_numbers;
+  QByteArray m_added;
+  quint32 m_addedCount;
+};
+
+// This class implements the state of a 'RecordingWriter' since the last
+// keyframe.
+class Encoder {
+ public:
+  Encoder() : m_addedNodes(0) {}
+
+  // Forget everything stored so far, which starts a keyframe.
+  void clear() {
+    m_pens.clear();
+    m_brushes.clear();
+    m_fonts.clear();
+    m_strings.clear();
+    m_numbers.clear();
+  }
+
+  // Write the record of the frame with the specified 'root', 'kind', and
+  // 'time' to the specified 'out'.
+  void writeFrame(QDataStream& out,
+                  FrameKind kind,
+                  double time,
+                  const Node& root);
+
+  quint32 pen(const QPen& pen) { return m_pens.intern(serialized(pen)); }
+  quint32 brush(const QBrush& brush) {
+    return m_brushes.intern(serialized(brush));
+  }
+  quint32 font(const QFont& font) { return m_fonts.intern(serialized(font)); }
+  quint32 string(const std::string& string) {
+    return m_strings.intern(
+        serialized(QByteArray(string.data(), int(string.size()))));
+  }
+
+  // Return the number of the specified 'd', which must have been stored.
+  quint32 number(const Drawing& d) const {
+    return m_numbers.find(&d)->second.first;
+  }
+
+ private:
+  // Write the nodes of the specified 'root' that were not stored yet to the
+  // specified 'out', children first.
+  void writeNodes(QDataStream& out, const Node& root);
+
+  InternTable m_pens;
+  InternTable m_brushes;
+  InternTable m_fonts;
+  InternTable m_strings;
+
+  // The numbers of the stored nodes, which are kept alive so that their
+  // addresses are not reused
+  std::unordered_map<const Drawing*, std::pair<quint32, Node> > m_numbers;
+  quint32 m_addedNodes;
+};
+
+// This class implements a visitor that writes a node whose children were
+// stored already.
+class WriteNode : public boost::static_visitor<> {
+ public:
+  WriteNode(Encoder& encoder, QDataStream& out)
+      : m_encoder(encoder), m_out(out) {}
+
+  void operator()(const DrawPoint& d) const {
+    m_out << quint8(e_POINT) << m_encoder.pen(d.pen) << d.p;
+  }
+  void operator()(const DrawLine& d) const {
+    m_out << quint8(e_LINE) << m_encoder.pen(d.pen) << d.p1 << d.p2;
+  }
+  void operator()(const DrawRect& d) const {
+    m_out << quint8(e_RECT) << m_encoder.pen(d.pen) << m_encoder.brush(d.brush)
+          << d.rect;
+  }
+  void operator()(const DrawRoundedRect& d) const {
+    m_out << quint8(e_ROUNDED_RECT) << m_encoder.pen(d.pen)
+          << m_encoder.brush(d.brush) << d.rect << d.xRadius << d.yRadius
+          << quint8(d.absolute);
+  }
+  void operator()(const DrawText& d) const {
+    m_out << quint8(e_TEXT) << m_encoder.pen(d.pen) << m_encoder.brush(d.brush)
+          << m_encoder.font(d.font) << d.position << m_encoder.string(d.text);
+  }
+  void operator()(const DrawEllipse& d) const {
+    m_out << quint8(e_ELLIPSE) << m_encoder.pen(d.pen)
+          << m_encoder.brush(d.brush) << d.rect;
+  }
+  void operator()(const DrawArc& d) const { writeSegment(e_ARC, d); }
+  void operator()(const DrawPie& d) const { writeSegment(e_PIE, d); }
+  void operator()(const DrawChord& d) const { writeSegment(e_CHORD, d); }
+  void operator()(const DrawNothing&) const { m_out << quint8(e_NOTHING); }
+  void operator()(const DrawOver& d) const {
+    m_out << quint8(e_OVER) << m_encoder.number(*d.d1)
+          << m_encoder.number(*d.d2);
+  }
+  void operator()(const DrawTransform& d) const {
+    m_out << quint8(e_TRANSFORM) << d.t << m_encoder.number(*d.d);
+  }
+  void operator()(const DrawCached& d) const {
+    m_out << quint8(e_CACHED) << m_encoder.number(*d.d) << quint64(d.hash);
+  }
+  void operator()(const DrawInstances& d) const {
+    m_out << quint8(e_INSTANCES) << m_encoder.number(*d.d)
+          << quint32(d.transforms->size());
+    for (const QTransform& t : *d.transforms)
+      m_out << t;
+    m_out << quint32(d.colors->size());
+    for (const QColor& color : *d.colors)
+      m_out << color;
+  }
+  void operator()(const DrawGroup& d) const {
+    m_out << quint8(e_GROUP) << quint32(d.children->size());
+    for (const Drawing& child : *d.children)
+      m_out << m_encoder.number(child);
+  }
+  void operator()(const DrawLOD& d) const {
+    m_out << quint8(e_LOD) << quint32(d.levels->size());
+    for (std::size_t i = 0; i < d.levels->size(); ++i)
+      m_out << (*d.minScales)[i] << m_encoder.number((*d.levels)[i]);
+  }
+
+ private:
+  // Write the specified 'd', an arc, pie, or chord, with the specified 'tag'.
+  template <typename Segment>
+  void writeSegment(NodeTag tag, const Segment& d) const {
+    m_out << quint8(tag) << m_encoder.pen(d.pen) << m_encoder.brush(d.brush)
+          << d.rect << d.startAngle << d.spanAngle;
+  }
+
+  Encoder& m_encoder;
+  QDataStream& m_out;
+};
+
+void Encoder::writeFrame(QDataStream& out,
+                         FrameKind kind,
+                         double time,
+                         const Node& root) {
+  // The nodes are written first since they determine the interned values
+  // that are stored in front of them.
+  QByteArray nodes;
+  {
+    QDataStream nodeStream(&nodes, QIODevice::WriteOnly);
+    configure(nodeStream);
+    writeNodes(nodeStream, root);
+  }
+  out << quint8(kind) << time;
+  m_pens.writeAdded(out);
+  m_brushes.writeAdded(out);
+  m_fonts.writeAdded(out);
+  m_strings.writeAdded(out);
+  out << m_addedNodes;
+  out.writeRawData(nodes.constData(), nodes.size());
+  out << number(*root);
+  m_addedNodes = 0;
+}
+
+void Encoder::writeNodes(QDataStream& out, const Node& root) {
+  // Each node is pending twice: once to schedule its children and once to
+  // write it after them.
+  std::vector<std::pair<Node, bool> > pending(1, std::make_pair(root, false));
+  std::vector<Node> children;
+  while (!pending.empty()) {
+    const std::pair<Node, bool> task = pending.back();
+    pending.pop_back();
+    if (m_numbers.count(task.first.get()))
+      continue;
+    if (!task.second) {
+      pending.push_back(std::make_pair(task.first, true));
+      children.clear();
+      appendChildren(task.first, children);
+      for (const Node& child : children) {
+        if (!m_numbers.count(child.get()))
+          pending.push_back(std::make_pair(child, false));
+      }
+    } else {
+      boost::apply_visitor(WriteNode(*this, out), *task.first);
+      m_numbers.insert(std::make_pair(
+          task.first.get(),
+          std::make_pair(quint32(m_numbers.size()), task.first)));
+      ++m_addedNodes;
+    }
+  }
+}
+
+// An entry of the index of a recording
+struct IndexEntry {
+  IndexEntry() : time(0.0), offset(0), kind(e_KEYFRAME) {}
+  IndexEntry(double time_, quint64 offset_, quint8 kind_)
+      : time(time_), offset(offset_), kind(kind_) {}
+
+  double time;     // Time of the frame
+  quint64 offset;  // Position of the frame's record in the recording
+  quint8 kind;     // Kind of the frame
+};
+
+// Return 'true' if the specified 'in' has enough data left for the specified
+// 'count' items of at least the specified 'itemSize' bytes, and 'false'
+// otherwise. This keeps corrupt counts from causing huge allocations.
+bool plausible(QDataStream& in, quint32 count, qint64 itemSize) {
+  return in.status() == QDataStream::Ok &&
+         qint64(count) * itemSize <= in.device()->bytesAvailable();
+}
+
+// This class implements the state of a 'RecordingReader' since the last
+// keyframe it decoded.
+class Decoder {
+ public:
+  // Read the record of a frame from the specified 'in' and make its drawing
+  // the current one. Return 'true' on success, and 'false' if the record is
+  // corrupt, in which case the state is unspecified until the next keyframe.
+  bool readFrame(QDataStream& in);
+
+  // Return the drawing of the last frame read.
+  const Node& root() const { return m_root; }
+
+ private:
+  // Read a table of values of type 'T' from the specified 'in' and append
+  // them to the specified 'table'.
+  template <typename T>
+  static bool readTable(QDataStream& in, std::vector<T>& table) {
+    quint32 count = 0;
+    in >> count;
+    if (!plausible(in, count, 1))
+      return false;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+      T value;
+      in >> value;
+      table.push_back(value);
+    }
+    return in.status() == QDataStream::Ok;
+  }
+
+  // Read a number from the specified 'in' and load the element of the
+  // specified 'table' it refers to into the specified 'value'.
+  template <typename T>
+  static bool lookUp(QDataStream& in, const std::vector<T>& table, T& value) {
+    quint32 number = 0;
+    in >> number;
+    if (in.status() != QDataStream::Ok || number >= table.size())
+      return false;
+    value = table[number];
+    return true;
+  }
+
+  // Read a node from the specified 'in' and append it to the nodes.
+  bool readNode(QDataStream& in);
+
+  // Read the pen, brush, rectangle, and angles of an arc, pie, or chord from
+  // the specified 'in' into the specified 'd'.
+  template <typename Segment>
+  bool readSegment(QDataStream& in, Segment& d) const {
+    if (!lookUp(in, m_pens, d.pen) || !lookUp(in, m_brushes, d.brush))
+      return false;
+    in >> d.rect >> d.startAngle >> d.spanAngle;
+    return true;
+  }
+
+  std::vector<QPen> m_pens;
+  std::vector<QBrush> m_brushes;
+  std::vector<QFont> m_fonts;
+  std::vector<QByteArray> m_strings;
+  std::vector<Node> m_nodes;
+  Node m_root;
+};
+
+bool Decoder::readFrame(QDataStream& in) {
+  quint8 kind = 0;
+  double time = 0.0;
+  in >> kind >> time;
+  if (kind == e_KEYFRAME) {
+    m_pens.clear();
+    m_brushes.clear();
+    m_fonts.clear();
+    m_strings.clear();
+    m_nodes.clear();
+  }
+  if (!readTable(in, m_pens) || !readTable(in, m_brushes) ||
+      !readTable(in, m_fonts) || !readTable(in, m_strings))
+    return false;
+  quint32 count = 0;
+  in >> count;
+  if (!plausible(in, count, 1))
+    return false;
+  for (quint32 i = 0; i < count; ++i) {
+    if (!readNode(in))
+      return false;
+  }
+  Node root;
+  if (!lookUp(in, m_nodes, root))
+    return false;
+  m_root = root;
+  return true;
+}
+
+bool Decoder::readNode(QDataStream& in) {
+  quint8 tag = 0;
+  in >> tag;
+  Drawing d;
+  switch (tag) {
+    case e_POINT: {
+      DrawPoint point;
+      if (!lookUp(in, m_pens, point.pen))
+        return false;
+      in >> point.p;
+      d = point;
+    } break;
+    case e_LINE: {
+      DrawLine line;
+      if (!lookUp(in, m_pens, line.pen))
+        return false;
+      in >> line.p1 >> line.p2;
+      d = line;
+    } break;
+    case e_RECT: {
+      DrawRect rect;
+      if (!lookUp(in, m_pens, rect.pen) || !lookUp(in, m_brushes, rect.brush))
+        return false;
+      in >> rect.rect;
+      d = rect;
+    } break;
+    case e_ROUNDED_RECT: {
+      DrawRoundedRect rect;
+      quint8 absolute = 0;
+      if (!lookUp(in, m_pens, rect.pen) || !lookUp(in, m_brushes, rect.brush))
+        return false;
+      in >> rect.rect >> rect.xRadius >> rect.yRadius >> absolute;
+      rect.absolute = absolute != 0;
+      d = rect;
+    } break;
+    case e_TEXT: {
+      DrawText text;
+      QByteArray string;
+      if (!lookUp(in, m_pens, text.pen) ||
+          !lookUp(in, m_brushes, text.brush) ||
+          !lookUp(in, m_fonts, text.font))
+        return false;
+      in >> text.position;
+      if (!lookUp(in, m_strings, string))
+        return false;
+      text.text.assign(string.constData(), string.size());
+      d = std::move(text);
+    } break;
+    case e_ELLIPSE: {
+      DrawEllipse ellipse;
+      if (!lookUp(in, m_pens, ellipse.pen) ||
+          !lookUp(in, m_brushes, ellipse.brush))
+        return false;
+      in >> ellipse.rect;
+      d = ellipse;
+    } break;
+    case e_ARC: {
+      DrawArc arc;
+      if (!readSegment(in, arc))
+        return false;
+      d = arc;
+    } break;
+    case e_PIE: {
+      DrawPie pie;
+      if (!readSegment(in, pie))
+        return false;
+      d = pie;
+    } break;
+    case e_CHORD: {
+      DrawChord chord;
+      if (!readSegment(in, chord))
+        return false;
+      d = chord;
+    } break;
+    case e_NOTHING:
+      break;
+    case e_OVER: {
+      Node d1;
+      Node d2;
+      if (!lookUp(in, m_nodes, d1) || !lookUp(in, m_nodes, d2))
+        return false;
+      d = DrawOver(d1, d2);
+    } break;
+    case e_TRANSFORM: {
+      QTransform t;
+      Node child;
+      in >> t;
+      if (!lookUp(in, m_nodes, child))
+        return false;
+      d = DrawTransform(t, child);
+    } break;
+    case e_CACHED: {
+      Node child;
+      quint64 hash = 0;
+      if (!lookUp(in, m_nodes, child))
+        return false;
+      in >> hash;
+      d = DrawCached(child, std::size_t(hash));
+    } break;
+    case e_INSTANCES: {
+      Node child;
+      quint32 count = 0;
+      if (!lookUp(in, m_nodes, child))
+        return false;
+      in >> count;
+      if (!plausible(in, count, 9 * 8))
+        return false;
+      std::vector<QTransform> transforms(count);
+      for (QTransform& t : transforms)
+        in >> t;
+      in >> count;
+      if (!plausible(in, count, 1))
+        return false;
+      std::vector<QColor> colors(count);
+      for (QColor& color : colors)
+        in >> color;
+      DrawInstances instances(Drawing(), std::move(transforms),
+                              std::move(colors));
+      instances.d = child;
+      d = std::move(instances);
+    } break;
+    case e_GROUP: {
+      quint32 count = 0;
+      in >> count;
+      if (!plausible(in, count, 4))
+        return false;
+      std::vector<Drawing> children;
+      children.reserve(count);
+      for (quint32 i = 0; i < count; ++i) {
+        Node child;
+        if (!lookUp(in, m_nodes, child))
+          return false;
+        children.push_back(*child);
+      }
+      d = DrawGroup(std::move(children));
+    } break;
+    case e_LOD: {
+      quint32 count = 0;
+      in >> count;
+      if (!plausible(in, count, 8 + 4))
+        return false;
+      std::vector<Drawing> levels;
+      std::vector<double> minScales(count);
+      levels.reserve(count);
+      for (quint32 i = 0; i < count; ++i) {
+        Node level;
+        in >> minScales[i];
+        // The thresholds must decrease; 'NaN' fails either comparison.
+        if (!(i == 0 ? minScales[i] == minScales[i]
+                     : minScales[i] <= minScales[i - 1]) ||
+            !lookUp(in, m_nodes, level))
+          return false;
+        levels.push_back(*level);
+      }
+      d = DrawLOD(std::move(levels), std::move(minScales));
+    } break;
+    default:
+      return false;
+  }
+  if (in.status() != QDataStream::Ok)
+    return false;
+  m_nodes.push_back(std::make_shared<const Drawing>(std::move(d)));
+  return true;
+}
+
+// Return a byte array that refers to the specified 'size' bytes at the
+// specified 'data' without copying them.
+QByteArray rawBytes(const uchar* data, qint64 size) {
+  return QByteArray::fromRawData(reinterpret_cast<const char*>(data),
+                                 int(size));
+}
+}
+
+struct RecordingWriter::Impl {
+  explicit Impl(QIODevice& device_)
+      : device(device_),
+        keyframeInterval(300),
+        framesSinceKeyframe(0),
+        offset(quint64(std::max(device_.pos(), qint64(0)))),
+        failed(false) {}
+
+  // Write the specified 'bytes' to the device.
+  void write(const QByteArray& bytes) {
+    if (device.write(bytes) != bytes.size())
+      failed = true;
+    offset += bytes.size();
+  }
+
+  QIODevice& device;
+  Encoder encoder;
+  int keyframeInterval;
+  int framesSinceKeyframe;
+  quint64 offset;  // Position in 'device' of the next byte written
+  std::vector<IndexEntry> index;
+  bool failed;
+};
+
+RecordingWriter::RecordingWriter(QIODevice& device) : m_impl(new Impl(device)) {
+  QByteArray header(magic, magicSize);
+  header.append(char(version));
+  m_impl->write(header);
+}
+
+RecordingWriter::~RecordingWriter() {}
+
+void RecordingWriter::setKeyframeInterval(int frames) {
+  m_impl->keyframeInterval = frames;
+}
+
+void RecordingWriter::addFrame(double time, const Drawing& frame) {
+  FrameKind kind = e_DELTA_FRAME;
+  if (m_impl->index.empty() ||
+      m_impl->framesSinceKeyframe >= m_impl->keyframeInterval) {
+    kind = e_KEYFRAME;
+    m_impl->encoder.clear();
+    m_impl->framesSinceKeyframe = 0;
+  }
+  ++m_impl->framesSinceKeyframe;
+
+  QByteArray record;
+  {
+    QDataStream out(&record, QIODevice::WriteOnly);
+    configure(out);
+    m_impl->encoder.writeFrame(out, kind, time,
+                               std::make_shared<const Drawing>(frame));
+  }
+  m_impl->index.push_back(IndexEntry(time, m_impl->offset, quint8(kind)));
+  m_impl->write(record);
+}
+
+bool RecordingWriter::finish() {
+  QByteArray index;
+  {
+    QDataStream out(&index, QIODevice::WriteOnly);
+    configure(out);
+    out << quint32(m_impl->index.size());
+    for (const IndexEntry& entry : m_impl->index)
+      out << entry.time << entry.offset << entry.kind;
+    out << quint64(m_impl->offset);
+  }
+  m_impl->write(index);
+  m_impl->encoder.clear();
+  return !m_impl->failed;
+}
+
+struct RecordingReader::Impl {
+  Impl() : data(0), size(0), decoded(0), hasDecoded(false) {}
+
+  // Decode the frame with the specified 'index' and return 'true' on
+  // success, and 'false' otherwise.
+  bool decode(std::size_t index) {
+    const quint64 end =
+        index + 1 < entries.size() ? entries[index + 1].offset : indexOffset;
+    const quint64 begin = entries[index].offset;
+    const QByteArray bytes = rawBytes(data + begin, qint64(end - begin));
+    QDataStream in(bytes);
+    configure(in);
+    return decoder.readFrame(in);
+  }
+
+  QFile file;
+  const uchar* data;  // The mapped file, or 0
+  qint64 size;
+  quint64 indexOffset;
+  std::vector<IndexEntry> entries;
+  Decoder decoder;
+  std::size_t decoded;  // Index of the frame 'decoder' holds, if 'hasDecoded'
+  bool hasDecoded;
+};
+
+RecordingReader::RecordingReader() : m_impl(new Impl()) {}
+
+RecordingReader::~RecordingReader() {}
+
+bool RecordingReader::open(const QString& fileName) {
+  close();
+  Impl& impl = *m_impl;
+  impl.file.setFileName(fileName);
+  if (!impl.file.open(QIODevice::ReadOnly))
+    return false;
+  impl.size = impl.file.size();
+  if (impl.size >= headerSize + indexOffsetSize)
+    impl.data = impl.file.map(0, impl.size);
+  if (!impl.data) {
+    close();
+    return false;
+  }
+
+  {
+    const QByteArray bytes = rawBytes(impl.data + impl.size - indexOffsetSize,
+                                      indexOffsetSize);
+    QDataStream in(bytes);
+    configure(in);
+    in >> impl.indexOffset;
+  }
+  const quint64 indexEnd = quint64(impl.size - indexOffsetSize);
+  if (impl.indexOffset < quint64(headerSize) || impl.indexOffset > indexEnd) {
+    close();
+    return false;
+  }
+
+  const QByteArray bytes = rawBytes(impl.data + impl.indexOffset,
+                                    qint64(indexEnd - impl.indexOffset));
+  QDataStream in(bytes);
+  configure(in);
+  quint32 count = 0;
+  in >> count;
+  bool valid = plausible(in, count, 8 + 8 + 1);
+  quint64 previousOffset = 0;
+  for (quint32 i = 0; valid && i < count; ++i) {
+    IndexEntry entry;
+    in >> entry.time >> entry.offset >> entry.kind;
+    valid = in.status() == QDataStream::Ok &&
+            entry.offset >= quint64(headerSize) &&
+            entry.offset >= previousOffset &&
+            entry.offset < impl.indexOffset &&
+            (impl.entries.empty() ? entry.kind == e_KEYFRAME
+                                  : entry.time >= impl.entries.back().time);
+    previousOffset = entry.offset;
+    impl.entries.push_back(entry);
+  }
+  const quint64 start =
+      (impl.entries.empty() ? impl.indexOffset : impl.entries.front().offset) -
+      headerSize;
+  if (!valid || std::memcmp(impl.data + start, magic, magicSize) != 0 ||
+      impl.data[start + magicSize] != version) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void RecordingReader::close() {
+  Impl& impl = *m_impl;
+  if (impl.data)
+    impl.file.unmap(const_cast<uchar*>(impl.data));
+  impl.file.close();
+  impl.data = 0;
+  impl.size = 0;
+  impl.indexOffset = 0;
+  impl.entries.clear();
+  impl.decoder = Decoder();
+  impl.hasDecoded = false;
+}
+
+std::size_t RecordingReader::frameCount() const {
+  return m_impl->entries.size();
+}
+
+double RecordingReader::frameTime(std::size_t index) const {
+  return m_impl->entries[index].time;
+}
+
+boost::optional<Drawing> RecordingReader::frame(std::size_t index) {
+  Impl& impl = *m_impl;
+  if (!impl.hasDecoded || impl.decoded != index) {
+    // Decode forward from the last decoded frame if no keyframe is in the
+    // way, and from the keyframe preceding 'index' otherwise. The first frame
+    // is always a keyframe.
+    std::size_t first = index;
+    while (first > 0 && impl.entries[first].kind != e_KEYFRAME)
+      --first;
+    if (impl.hasDecoded && first <= impl.decoded && impl.decoded < index)
+      first = impl.decoded + 1;
+    for (std::size_t i = first; i <= index; ++i) {
+      impl.hasDecoded = impl.decode(i);
+      if (!impl.hasDecoded)
+        return boost::none;
+      impl.decoded = i;
+    }
+  }
+  return Drawing(*impl.decoder.root());
+}
+
+boost::optional<Drawing> RecordingReader::frameAt(double time) {
+  const std::vector<IndexEntry>& entries = m_impl->entries;
+  if (entries.empty())
+    return boost::none;
+  const std::vector<IndexEntry>::const_iterator it = std::upper_bound(
+      entries.begin(), entries.end(), time,
+      [](double t, const IndexEntry& entry) { return t < entry.time; });
+  return frame(it == entries.begin() ? 0 : (it - entries.begin()) - 1);
+}
+
+Animation replayAnimation(const std::shared_ptr<RecordingReader>& reader) {
+  return Animation::fromValuePullFunc(
+      [reader](double time) { return reader->frameAt(time); });
+}
+}
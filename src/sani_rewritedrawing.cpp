@@ -0,0 +1,89 @@
+#include <sani/rewritedrawing.hpp>
+
+#include <boost/functional/hash.hpp>
+
+#include <unordered_map>
+#include <utility>
+
+namespace sani {
+
+namespace {
+// A unit of pending work of 'rewriteDrawing'.
+struct Task {
+  Task(const DrawingNode& node_, int context_, bool build_,
+       std::size_t arity_)
+      : node(node_), context(context_), build(build_), arity(arity_) {}
+
+  DrawingNode node;   // Drawing to rewrite
+  int context;        // Context in which 'node' is rewritten
+  bool build;         // If 'true', the rewritten operands of 'node' are on
+                      // top of the result stack and only need to be combined.
+  std::size_t arity;  // Number of rewritten operands if 'build'
+};
+
+// Do nothing. This is the deleter of the unowned root drawing.
+void keep(const Drawing*) {}
+}
+
+DrawingRewriter::~DrawingRewriter() {}
+
+Drawing rewriteDrawing(const Drawing& d, DrawingRewriter& rewriter) {
+  typedef std::pair<const Drawing*, int> Key;
+  typedef std::unordered_map<Key, DrawingNode, boost::hash<Key>> Memo;
+
+  const DrawingNode root(&d, &keep);
+  std::vector<Task> tasks(1, Task(root, 0, false, 0));
+  std::vector<DrawingNode> results;
+  std::vector<DrawingRewriter::Operand> operands;
+  Memo memo;  // Rewritten composite nodes
+  while (!tasks.empty()) {
+    const Task task = tasks.back();
+    tasks.pop_back();
+    const Key key(task.node.get(), task.context);
+    if (task.build) {
+      const std::size_t first = results.size() - task.arity;
+      const DrawingNode result = rewriter.rebuild(
+          task.node, task.context, &results[first], task.arity);
+      results.erase(results.begin() + first, results.end());
+      memo[key] = result;
+      results.push_back(result);
+      continue;
+    }
+    const Memo::const_iterator it = memo.find(key);
+    if (it != memo.end()) {
+      results.push_back(it->second);
+      continue;
+    }
+    operands.clear();
+    rewriter.appendOperands(task.node, task.context, operands);
+    if (operands.empty()) {
+      results.push_back(rewriter.rebuild(task.node, task.context, 0, 0));
+      continue;
+    }
+    tasks.push_back(Task(task.node, task.context, true, operands.size()));
+    for (std::size_t i = operands.size(); i > 0; --i)
+      tasks.push_back(
+          Task(operands[i - 1].node, operands[i - 1].context, false, 0));
+  }
+  const DrawingNode& result = results.back();
+  return result == root ? d : *result;
+}
+
+bool sameDrawings(const std::vector<Drawing>& drawings,
+                  const DrawingNode* nodes, std::size_t count) {
+  if (drawings.size() != count)
+    return false;
+  for (std::size_t i = 0; i < count; ++i)
+    if (nodes[i].get() != &drawings[i])
+      return false;
+  return true;
+}
+
+std::vector<Drawing> copyDrawings(const DrawingNode* nodes, std::size_t count) {
+  std::vector<Drawing> result;
+  result.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+    result.push_back(*nodes[i]);
+  return result;
+}
+}
@@ -0,0 +1,92 @@
+#include <sani/textcache.hpp>
+
+#include <sani/lrucache.hpp>
+
+#include <boost/functional/hash.hpp>
+#include <boost/optional.hpp>
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QStaticText>
+#include <atomic>
+#include <string>
+
+namespace sani {
+
+namespace {
+// The capacity of the text caches in bytes of text
+std::atomic<std::size_t> capacity(1024 * 1024);
+
+// The cost, in addition to the bytes of text, of a cached text
+const std::size_t entryOverhead = 64;
+
+// The identity of a cached text
+struct TextKey {
+  TextKey(const std::string& text_, const QFont& font_)
+      : text(text_), font(font_) {}
+
+  bool operator==(const TextKey& other) const {
+    return text == other.text && font == other.font;
+  }
+
+  std::string text;
+  QFont font;
+};
+
+// Hash only the text: labels rarely share their text but not their font, and
+// hashing a 'QFont' is comparatively expensive.
+std::size_t hash_value(const TextKey& key) {
+  return boost::hash<std::string>()(key.text);
+}
+
+// Laid out text and the distance from its top to its baseline
+struct Text {
+  QStaticText staticText;
+  qreal ascent;
+};
+
+typedef LruCache<TextKey, Text> Cache;
+
+// Return the text cache of the calling thread.
+Cache& threadCache() {
+  static thread_local Cache cache(capacity);
+  const std::size_t maxCost = capacity;
+  if (cache.maxCost() != maxCost)
+    cache.setMaxCost(maxCost);
+  return cache;
+}
+
+// Return the specified 'text' laid out with the specified 'font'.
+Text layOut(const std::string& text, const QFont& font) {
+  Text result;
+  result.staticText.setText(
+      QString::fromUtf8(text.data(), int(text.size())));
+  result.staticText.setTextFormat(Qt::PlainText);
+  result.staticText.setPerformanceHint(QStaticText::AggressiveCaching);
+  result.staticText.prepare(QTransform(), font);
+  result.ascent = QFontMetricsF(font).ascent();
+  return result;
+}
+}
+
+void paintText(const DrawText& d, QPainter& painter) {
+  if (d.text.empty())
+    return;
+  if (d.text.find('\n') != std::string::npos) {
+    painter.drawText(d.position,
+                     QString::fromUtf8(d.text.data(), int(d.text.size())));
+    return;
+  }
+
+  Cache& cache = threadCache();
+  const TextKey key(d.text, d.font);
+  boost::optional<Text> opText = cache.find(key);
+  if (!opText) {
+    opText = layOut(d.text, d.font);
+    cache.insert(key, *opText, d.text.size() + entryOverhead);
+  }
+  painter.drawStaticText(d.position - QPointF(0.0, opText->ascent),
+                         opText->staticText);
+}
+
+void setTextCacheCapacity(std::size_t bytes) { capacity = bytes; }
+}
@@ -0,0 +1,90 @@
+#include <sani/tileddraw.hpp>
+
+#include <sani/idlehelpers.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <QImage>
+#include <QRect>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace sani {
+
+namespace {
+// The state shared by the threads drawing the tiles of one image
+struct TileJob {
+  TileJob(const Drawing& d_,
+          const QImage& image,
+          uchar* bits_,
+          const QTransform& toImage_,
+          QPainter::RenderHints hints_)
+      : d(d_),
+        bits(bits_),
+        bytesPerLine(image.bytesPerLine()),
+        format(image.format()),
+        toImage(toImage_),
+        fromImage(toImage_.inverted()),
+        hints(hints_),
+        next(0) {}
+
+  // Draw tiles until none is left.
+  void run() {
+    for (;;) {
+      const std::size_t i = next++;
+      if (i >= tiles.size())
+        return;
+      drawTile(tiles[i]);
+    }
+  }
+
+  // Draw the specified 'tile' of the image.
+  void drawTile(const QRect& tile) {
+    QImage tileImage(bits + tile.y() * bytesPerLine + tile.x() * 4,
+                     tile.width(), tile.height(), bytesPerLine, format);
+    QPainter painter(&tileImage);
+    painter.setRenderHints(hints);
+    painter.setTransform(toImage *
+                         QTransform::fromTranslate(-tile.x(), -tile.y()));
+    draw(d, painter, fromImage.mapRect(QRectF(tile)));
+  }
+
+  const Drawing& d;
+  uchar* const bits;
+  const int bytesPerLine;
+  const QImage::Format format;
+  const QTransform toImage;
+  const QTransform fromImage;
+  const QPainter::RenderHints hints;
+  std::vector<QRect> tiles;
+  std::atomic<std::size_t> next;  // Index of the next tile to draw
+};
+}
+
+void drawTiled(const Drawing& d,
+               QImage& image,
+               const QTransform& toImage,
+               QPainter::RenderHints hints,
+               int tileSize) {
+  if (image.isNull())
+    return;
+  if (image.depth() != 32 || !toImage.isInvertible()) {
+    QPainter painter(&image);
+    painter.setRenderHints(hints);
+    painter.setTransform(toImage);
+    draw(d, painter);
+    return;
+  }
+
+  // Detach 'image' once, here, rather than from the tile threads.
+  TileJob job(d, image, image.bits(), toImage, hints);
+  for (int y = 0; y < image.height(); y += tileSize)
+    for (int x = 0; x < image.width(); x += tileSize)
+      job.tiles.push_back(QRect(x, y, std::min(tileSize, image.width() - x),
+                                std::min(tileSize, image.height() - y)));
+
+  const boost::function<void()> run = boost::bind(&TileJob::run, &job);
+  runWithIdleHelpers(job.tiles.size() - 1, run, run);
+}
+}
@@ -15,8 +15,23 @@ UserInput::UserInput(sfrp::Behavior<QPointF> mousePos_,
                      sfrp::Behavior<boost::optional<int>> keyRelease_)
     : mousePos(std::move(mousePos_)),
       mousePress(std::move(mousePress_)),
+      mouseRelease(std::move(mouseRelease_)),
       keyPress(std::move(keyPress_)),
       keyRelease(std::move(keyRelease_)) {}
+
+UserInput::UserInput(
+    sfrp::Behavior<QPointF> mousePos_,
+    sfrp::Behavior<boost::optional<int>> mousePress_,
+    sfrp::Behavior<boost::optional<int>> mouseRelease_,
+    sfrp::Behavior<boost::optional<int>> keyPress_,
+    sfrp::Behavior<boost::optional<int>> keyRelease_,
+    sfrp::Behavior<boost::optional<std::vector<InputEvent>>> inputEvents_)
+    : mousePos(std::move(mousePos_)),
+      mousePress(std::move(mousePress_)),
+      mouseRelease(std::move(mouseRelease_)),
+      keyPress(std::move(keyPress_)),
+      keyRelease(std::move(keyRelease_)),
+      inputEvents(std::move(inputEvents_)) {}
 }
 
 // Used only for compilation testing